@@ -1,13 +1,52 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "algen.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <time.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Estado do percurso após INTERVALO_RETOMADA * (k + 1) movimentos válidos,
+ * sem colisão nem chegada: de onde a avaliação de um genótipo com o mesmo
+ * prefixo pode continuar. */
+typedef struct _ponto_retomada {
+    int32_t pos;
+    int32_t repeticoes;
+} PontoRetomada;
 
+/* O genótipo fica em uma de duas codificações: uma letra por movimento em
+ * `genotipo`, ou 2 bits por movimento (32 por palavra) em `genes`, na ordem
+ * da tabela de vizinhança (0 = C, 1 = B, 2 = E, 3 = D). O outro é NULL.
+ * `pontos` guarda os `num_pontos` primeiros pontos de retomada do percurso,
+ * sempre válidos para o genótipo atual; é NULL fora das arenas. */
 typedef struct _no {
     char *genotipo;
+    uint64_t *genes;
+    PontoRetomada *pontos;
+    int num_pontos;
     int tam_genotipo;
+    int capacidade;             /* movimentos que cabem no buffer do genótipo */
     float fitness;
     int totalMov;
     int x, y;
@@ -15,9 +54,50 @@ typedef struct _no {
     struct _no *proximo;
 } No;
 
+/* Arena contígua de indivíduos: os nós e os genótipos ficam em dois blocos
+ * reaproveitados entre gerações; o genótipo do indivíduo i, seguido dos seus
+ * pontos de retomada, ocupa a fatia genes[i * bytes_por_fatia(arena)]. */
+typedef struct _arena {
+    No *individuos;
+    unsigned char *genes;
+    int quantidade;
+    int capacidade;
+    int compacta;
+    int tam_max;
+    unsigned long long alocacoes;     /* blocos alocados, para a telemetria */
+    unsigned long long bytes_alocados;
+} Arena;
+
+/* Buffers de ordenação reaproveitados: cada entrada guarda a chave de
+ * fitness nos 32 bits altos e o índice do indivíduo nos 32 baixos.
+ * `acumulado` guarda a soma dos pesos da amostragem universal e só é
+ * alocado quando ela é usada. */
+typedef struct _ranking {
+    uint64_t *entradas;
+    uint64_t *auxiliar;
+    No *individuos;
+    int capacidade;
+    double *acumulado;
+    int capacidade_acumulado;
+    unsigned long long alocacoes;
+    unsigned long long bytes_alocados;
+} Ranking;
+
+/* Telemetria opcional da lista; com `sink` NULL fica desligada. */
+typedef struct _telemetria {
+    SinkTelemetria sink;
+    void *contexto;
+    int geracao;
+} Telemetria;
+
+/* A lista alterna entre duas arenas: a geração atual e a reserva onde a
+ * próxima geração é montada, de modo que uma execução estável não aloca. */
 typedef struct _lista {
-    No *inicio;
-    No *fim;
+    Arena atual;
+    Arena reserva;
+    Ranking ranking;
+    Configuracao config;
+    Telemetria telemetria;
 } Lista;
 
 typedef struct _posicao {
@@ -25,19 +105,367 @@ typedef struct _posicao {
     int y;
 } Posicao;
 
+/* O mapa é guardado com uma borda de uma célula de parede em toda a volta:
+ * a célula (x, y) fica na posição (x + 1) * largura + (y + 1) dos buffers
+ * planos, e nenhum passo precisa testar limites. Os caracteres não são
+ * copiados: quando o mapa vem de um arquivo, as linhas são lidas direto dos
+ * bytes mapeados, indexadas por `inicio_linha`. Um mapa binário não tem
+ * texto, e seus buffers apontam para dentro do próprio mapeamento. */
 typedef struct _matriz {
     unsigned int linhas, colunas;
-    char **mapa;
+    ptrdiff_t largura;          /* colunas + 2 */
+    size_t total_celulas;       /* (linhas + 2) * largura */
+    const char *texto;          /* conteúdo do arquivo, ou NULL */
+    size_t *inicio_linha;       /* deslocamento de cada linha em `texto` */
+    void *mapeamento;           /* região mapeada (ou lida) que contém `texto` */
+    size_t tamanho_mapeamento;
+    int mapeado;                /* 1 se `mapeamento` veio de mmap() */
+    uint64_t *livre;            /* bitset: 1 se a célula é transitável */
+    unsigned char *vizinhanca;  /* máscara de direções livres | grau << 4 */
+    uint32_t *distancia;        /* passos até o objetivo por célula, ou NULL */
+    uint32_t distancia_maxima;  /* maior distância finita do campo */
+    ModoFitness modo_fitness;
     int x_inicial, y_inicial;
     int x_final, y_final;
+    ptrdiff_t pos_inicial, pos_final;
+    Avaliador *avaliador;
+    struct _cache_fitness *cache; /* resultados dos filhos já avaliados, ou NULL */
 } Matriz;
 
+/* Contexto de avaliação: marcas de visita por célula, carimbadas com o número
+ * da rodada, de modo que nenhuma limpeza é necessária entre avaliações. */
+typedef struct _avaliador {
+    const Matriz *matriz;
+    unsigned int *marcas;
+    unsigned int rodada;
+    /* Avaliação em lote: cada célula guarda (rodada << 8) | pistas que a
+     * visitaram, e os passos dos genótipos são transpostos para que o
+     * passo i de todas as pistas fique contíguo. Alocados sob demanda. */
+    uint32_t *marcas_lote;
+    uint32_t rodada_lote;
+    int32_t *passos_lote;
+    int capacidade_passos;
+    /* Cruzamento posicional: índice da primeira visita do primeiro pai a
+     * cada célula carimbada em `marcas`. Alocado sob demanda. */
+    int32_t *indices_cruzamento;
+    size_t capacidade_celulas;  /* células cobertas pelos buffers acima */
+} Avaliador;
+
+/* Entrada do cache de fitness, protegida por um contador de sequência: a
+ * versão fica ímpar durante a escrita, e quem lê descarta a entrada se a
+ * versão mudou entre o início e o fim da leitura. */
+typedef struct _entrada_cache {
+    atomic_uint versao;
+    atomic_ullong chave;        /* hash do genótipo; 0 marca entrada vazia */
+    atomic_ullong dados[3];     /* fitness | tam, totalMov | colisoes, x | y */
+} EntradaCache;
+
+/* Tabela de endereçamento aberto, compartilhada pelas threads que avaliam o
+ * mesmo mapa. Guarda apenas filhos, cujo resultado depende só do genótipo. */
+typedef struct _cache_fitness {
+    EntradaCache *entradas;
+    size_t mascara;             /* capacidade - 1 (potência de 2) */
+    atomic_ullong consultas;
+    atomic_ullong acertos;
+    atomic_ullong insercoes;
+} CacheFitness;
+
+/* Gerador xoshiro256**: estado pequeno, rápido e independente por thread. */
+typedef struct _gerador {
+    uint64_t s[4];
+} Gerador;
+
+typedef struct _trabalhador {
+    PoolThreads *pool;
+    int indice;
+} Trabalhador;
+
+/* Pool de threads persistente: cada thread tem seu gerador e seu avaliador,
+ * e a thread que chama pool_executar() atua como trabalhador 0. */
+typedef struct _pool_threads {
+    Matriz *matriz;
+    int num_threads;
+    int threads_ativas;
+    pthread_t *threads;
+    Trabalhador *trabalhadores;
+    Gerador *geradores;
+    Avaliador **avaliadores;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_tarefa;
+    pthread_cond_t cond_fim;
+    void (*tarefa)(void *contexto, int indice);
+    void *contexto;
+    unsigned long rodada;
+    int pendentes;
+    int encerrar;
+    unsigned long long (*tempos)[TELEMETRIA_TOTAL_ETAPAS]; /* um acumulador por thread */
+} PoolThreads;
+
+#define CAPACIDADE_INICIAL 16
+
+/* Valores padrão de Configuracao. */
+#define POPULACAO_PADRAO 100
+#define ELITE_PADRAO 5
+#define MAX_FILHOS_PADRAO 45
+#define TAXA_MUTACAO_PADRAO 0.05f
+#define TAM_FILHO_PADRAO 100
+#define PASSEIO_MIN_PADRAO 10
+#define PASSEIO_MAX_PADRAO 100
+#define GERACOES_PADRAO 50
+#define INTERVALO_MIGRACAO_PADRAO 10
+#define MIGRANTES_PADRAO 2
+#define INTERVALO_ESTADO_PADRAO 10
+#define CACHE_FITNESS_PADRAO 0
+#define TAMANHO_TORNEIO_PADRAO 3
+#define PRESSAO_RANKING_PADRAO 2.0f
+#define FILA_POPULACOES_PADRAO 4
+
+/* Peso de cada passo de distância ao objetivo no fitness FITNESS_CAMINHO. */
+#define PESO_DISTANCIA_CAMINHO 100.0f
+
+static const char direcoes[] = {'C', 'B', 'D', 'E'};
+
+static uint64_t splitmix64(uint64_t *estado) {
+    uint64_t z = (*estado += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void gerador_semear(Gerador *gerador, uint64_t semente) {
+    for (int i = 0; i < 4; i++)
+        gerador->s[i] = splitmix64(&semente);
+}
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t gerador_proximo(Gerador *gerador) {
+    uint64_t *s = gerador->s;
+    const uint64_t resultado = rotl64(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return resultado;
+}
+
+/* Inteiro uniforme em [0, n) pelo método multiplicativo (sem divisão). */
+static inline int gerador_intervalo(Gerador *gerador, int n) {
+    return (int)(((gerador_proximo(gerador) >> 32) * (uint64_t)n) >> 32);
+}
+
+/* Real uniforme em [0, 1). */
+static inline float gerador_real(Gerador *gerador) {
+    return (float)(gerador_proximo(gerador) >> 40) * (1.0f / 16777216.0f);
+}
+
+/* Gerador usado pelas funções seriais da API pública. */
+static Gerador gerador_global = {{0x9E3779B97F4A7C15ULL, 0xBF58476D1CE4E5B9ULL,
+                                  0x94D049BB133111EBULL, 0x2545F4914F6CDD1DULL}};
+
+void semear_aleatorio(unsigned long long semente) {
+    gerador_semear(&gerador_global, semente);
+}
+
+static const char letra_vizinho[4] = {'C', 'B', 'E', 'D'};
+
+/* codigo_letra[c]: 1 + direção da letra c na ordem acima, ou 0 para letras
+ * inválidas (o indivíduo permanece na mesma célula). */
+static const unsigned char codigo_letra[256] = {['C'] = 1, ['B'] = 2, ['E'] = 3, ['D'] = 4};
+
+static inline size_t bytes_por_genotipo(int compacta, int tam_max) {
+    return compacta ? ((size_t)tam_max + 31) / 32 * sizeof(uint64_t) : (size_t)tam_max * sizeof(char);
+}
+
+/* Movimentos entre pontos de retomada consecutivos. */
+#define INTERVALO_RETOMADA 64
+
+/* Os pontos de retomada seguem o genótipo na fatia, alinhados a 8 bytes. */
+static inline size_t bytes_genes_fatia(const Arena *arena) {
+    return (bytes_por_genotipo(arena->compacta, arena->tam_max) + 7) & ~(size_t)7;
+}
+
+static inline size_t bytes_por_fatia(const Arena *arena) {
+    return bytes_genes_fatia(arena) + (size_t)(arena->tam_max / INTERVALO_RETOMADA) * sizeof(PontoRetomada);
+}
+
+static inline int gene_compacto(const uint64_t *genes, int i) {
+    return (int)((genes[i >> 5] >> ((i & 31) * 2)) & 3u);
+}
+
+static inline void definir_gene_compacto(uint64_t *genes, int i, int direcao) {
+    const int deslocamento = (i & 31) * 2;
+    genes[i >> 5] = (genes[i >> 5] & ~((uint64_t)3 << deslocamento)) | ((uint64_t)direcao << deslocamento);
+}
+
+static inline char letra_gene(const No *no, int i) {
+    return no->genes ? letra_vizinho[gene_compacto(no->genes, i)] : no->genotipo[i];
+}
+
+/* Lê nbits (1 a 64) a partir do bit `bit` de um vetor de palavras. */
+static inline uint64_t ler_bits(const uint64_t *v, size_t bit, int nbits) {
+    const size_t w = bit >> 6;
+    const int o = (int)(bit & 63);
+    uint64_t x = v[w] >> o;
+    if (o && o + nbits > 64) x |= v[w + 1] << (64 - o);
+    return nbits == 64 ? x : x & (((uint64_t)1 << nbits) - 1);
+}
+
+/* Escreve nbits (1 a 64) de x a partir do bit `bit`, preservando os vizinhos. */
+static inline void escrever_bits(uint64_t *v, size_t bit, uint64_t x, int nbits) {
+    const size_t w = bit >> 6;
+    const int o = (int)(bit & 63);
+    const uint64_t mascara = nbits == 64 ? ~(uint64_t)0 : (((uint64_t)1 << nbits) - 1);
+    v[w] = (v[w] & ~(mascara << o)) | (x << o);
+    if (o && o + nbits > 64) {
+        const int r = 64 - o;
+        v[w + 1] = (v[w + 1] & ~(mascara >> r)) | (x >> r);
+    }
+}
+
+/* Copia n genes compactados de origem[de..] para destino[para..], 32 por vez. */
+static void copiar_genes(uint64_t *destino, int para, const uint64_t *origem, int de, int n) {
+    while (n > 0) {
+        int bloco = n < 32 ? n : 32;
+        escrever_bits(destino, (size_t)para * 2, ler_bits(origem, (size_t)de * 2, bloco * 2), bloco * 2);
+        para += bloco;
+        de += bloco;
+        n -= bloco;
+    }
+}
+
+/* Preenche n genes aleatórios a partir de destino[para], 32 genes por sorteio. */
+static void sortear_genes(uint64_t *destino, int para, int n, Gerador *gerador) {
+    while (n > 0) {
+        int bloco = n < 32 ? n : 32;
+        escrever_bits(destino, (size_t)para * 2, gerador_proximo(gerador), bloco * 2);
+        para += bloco;
+        n -= bloco;
+    }
+}
+
+/* Copia o genótipo e as métricas de um indivíduo, convertendo a codificação
+ * quando origem e destino usam representações diferentes. */
+static void copiar_individuo(const No *origem, No *destino) {
+    const int n = origem->tam_genotipo;
+    if (origem->genes && destino->genes) {
+        memcpy(destino->genes, origem->genes, ((size_t)n + 31) / 32 * sizeof(uint64_t));
+    } else if (!origem->genes && !destino->genes) {
+        memcpy(destino->genotipo, origem->genotipo, (size_t)n * sizeof(char));
+    } else if (destino->genes) {
+        for (int i = 0; i < n; i++) {
+            int codigo = codigo_letra[(unsigned char)origem->genotipo[i]];
+            definir_gene_compacto(destino->genes, i, codigo ? codigo - 1 : 0);
+        }
+    } else {
+        for (int i = 0; i < n; i++)
+            destino->genotipo[i] = letra_vizinho[gene_compacto(origem->genes, i)];
+    }
+    destino->num_pontos = 0;
+    if (origem->pontos && destino->pontos) {
+        int k = origem->num_pontos;
+        if (k > destino->capacidade / INTERVALO_RETOMADA) k = destino->capacidade / INTERVALO_RETOMADA;
+        memcpy(destino->pontos, origem->pontos, (size_t)k * sizeof(PontoRetomada));
+        destino->num_pontos = k;
+    }
+    destino->tam_genotipo = n;
+    destino->totalMov = origem->totalMov;
+    destino->fitness = origem->fitness;
+    destino->x = origem->x;
+    destino->y = origem->y;
+    destino->colisoes = origem->colisoes;
+}
+
+static void arena_religar(Arena *arena) {
+    for (int i = 0; i < arena->quantidade; i++)
+        arena->individuos[i].proximo = (i + 1 < arena->quantidade) ? &arena->individuos[i + 1] : NULL;
+}
+
+/* Aponta o genótipo e os pontos de retomada do nó para a fatia `indice` do
+ * bloco de genes. */
+static inline void apontar_fatia(No *no, unsigned char *genes, int indice, const Arena *arena) {
+    unsigned char *fatia = genes + (size_t)indice * bytes_por_fatia(arena);
+    no->genotipo = arena->compacta ? NULL : (char *)fatia;
+    no->genes = arena->compacta ? (uint64_t *)fatia : NULL;
+    no->pontos = arena->tam_max >= INTERVALO_RETOMADA ? (PontoRetomada *)(fatia + bytes_genes_fatia(arena)) : NULL;
+    no->capacidade = arena->tam_max;
+}
+
+static int arena_reservar(Arena *arena, int capacidade) {
+    if (capacidade <= arena->capacidade) return 1;
+
+    size_t bytes_genes = (size_t)capacidade * bytes_por_fatia(arena);
+    No *individuos = malloc((size_t)capacidade * sizeof(No));
+    unsigned char *genes = malloc(bytes_genes);
+    if (!individuos || !genes) {
+        free(individuos);
+        free(genes);
+        return 0;
+    }
+    arena->alocacoes += 2;
+    arena->bytes_alocados += (size_t)capacidade * sizeof(No) + bytes_genes;
+
+    // Copia compactando: o indivíduo i passa a ocupar a fatia i da nova arena
+    for (int i = 0; i < arena->quantidade; i++) {
+        individuos[i] = arena->individuos[i];
+        apontar_fatia(&individuos[i], genes, i, arena);
+        copiar_individuo(&arena->individuos[i], &individuos[i]);
+    }
+
+    free(arena->individuos);
+    free(arena->genes);
+    arena->individuos = individuos;
+    arena->genes = genes;
+    arena->capacidade = capacidade;
+    arena_religar(arena);
+    return 1;
+}
+
+static No *arena_novo_individuo(Arena *arena) {
+    if (arena->quantidade == arena->capacidade) {
+        int capacidade = arena->capacidade ? arena->capacidade * 2 : CAPACIDADE_INICIAL;
+        if (!arena_reservar(arena, capacidade)) return NULL;
+    }
+    No *no = &arena->individuos[arena->quantidade];
+    apontar_fatia(no, arena->genes, arena->quantidade, arena);
+    no->num_pontos = 0;
+    no->tam_genotipo = 0;
+    no->totalMov = 0;
+    no->colisoes = 0;
+    no->proximo = NULL;
+    if (arena->quantidade > 0)
+        arena->individuos[arena->quantidade - 1].proximo = no;
+    arena->quantidade++;
+    return no;
+}
+
+static void arena_liberar(Arena *arena) {
+    free(arena->individuos);
+    free(arena->genes);
+    arena->individuos = NULL;
+    arena->genes = NULL;
+    arena->quantidade = arena->capacidade = 0;
+}
+
 No *cria_no(Matriz *matriz) {
     No *no = malloc(sizeof(No));
     if (!no) return NULL;
+    no->genotipo = malloc(PASSEIO_MAX_PADRAO * sizeof(char));
+    if (!no->genotipo) {
+        free(no);
+        return NULL;
+    }
+    no->genes = NULL;
+    no->pontos = NULL;
+    no->num_pontos = 0;
+    no->capacidade = PASSEIO_MAX_PADRAO;
     no->totalMov = 0;
     no->colisoes = 0;
-    no->genotipo = NULL;
     no->tam_genotipo = 0;
     cria_genotipo(matriz, no);
     no->fitness = calcula_fitness(matriz, no);
@@ -45,539 +473,4780 @@ No *cria_no(Matriz *matriz) {
     return no;
 }
 
-int obter_vizinhos_validos(Matriz *matriz, int x, int y, Posicao *vizinhos, int max_vizinhos) {
-    int count = 0;
-    if (x > 0 && count < max_vizinhos && matriz->mapa[x-1][y] != '#')
-        vizinhos[count++] = (Posicao){x-1, y};
-    if (x < (int)matriz->linhas - 1 && count < max_vizinhos && matriz->mapa[x+1][y] != '#')
-        vizinhos[count++] = (Posicao){x+1, y};
-    if (y > 0 && count < max_vizinhos && matriz->mapa[x][y-1] != '#')
-        vizinhos[count++] = (Posicao){x, y-1};
-    if (y < (int)matriz->colunas - 1 && count < max_vizinhos && matriz->mapa[x][y+1] != '#')
-        vizinhos[count++] = (Posicao){x, y+1};
-    return count;
+void liberar_no(No *no) {
+    if (!no) return;
+    free(no->genotipo);
+    free(no->genes);
+    free(no);
+}
+
+/* Direções na ordem dos bits da tabela de vizinhança: cima, baixo, esquerda, direita. */
+static const int delta_x[4] = {-1, 1, 0, 0};
+static const int delta_y[4] = {0, 0, -1, 1};
+
+/* escolha_vizinho[m][r]: direção do r-ésimo bit ligado da máscara m. */
+static const signed char escolha_vizinho[16][4] = {
+    {-1, -1, -1, -1}, {0, -1, -1, -1}, {1, -1, -1, -1}, {0, 1, -1, -1},
+    {2, -1, -1, -1},  {0, 2, -1, -1},  {1, 2, -1, -1},  {0, 1, 2, -1},
+    {3, -1, -1, -1},  {0, 3, -1, -1},  {1, 3, -1, -1},  {0, 1, 3, -1},
+    {2, 3, -1, -1},   {0, 2, 3, -1},   {1, 2, 3, -1},   {0, 1, 2, 3},
+};
+
+static inline ptrdiff_t posicao_celula(const Matriz *matriz, int x, int y) {
+    return (ptrdiff_t)(x + 1) * matriz->largura + (y + 1);
+}
+
+static inline int celula_livre(const Matriz *matriz, ptrdiff_t pos) {
+    return (int)((matriz->livre[(size_t)pos >> 6] >> ((size_t)pos & 63)) & 1u);
+}
+
+/* Deslocamento de cada direção no buffer com borda, na ordem da tabela. */
+static inline void passos_direcao(const Matriz *matriz, ptrdiff_t passo[4]) {
+    passo[0] = -matriz->largura;
+    passo[1] = matriz->largura;
+    passo[2] = -1;
+    passo[3] = 1;
+}
+
+/* Calcula as dimensões com borda e reserva o bitset de células livres,
+ * todo parede; as linhas do mapa são marcadas por indexar_linha(). */
+static int preparar_livre(Matriz *matriz) {
+    matriz->largura = (ptrdiff_t)matriz->colunas + 2;
+    matriz->total_celulas = ((size_t)matriz->linhas + 2) * (size_t)matriz->largura;
+    matriz->livre = calloc((matriz->total_celulas + 63) / 64, sizeof(uint64_t));
+    if (!matriz->livre) {
+        printf("Erro na alocacao do mapa\n");
+        return 0;
+    }
+    matriz->x_inicial = matriz->y_inicial = -1;
+    matriz->x_final = matriz->y_final = -1;
+    return 1;
+}
+
+/* Marca no bitset as células livres da linha `i`, registrando S e E. */
+static void indexar_linha(Matriz *matriz, unsigned int i, const char *origem) {
+    uint64_t *livre = matriz->livre;
+    size_t pos = (size_t)posicao_celula(matriz, (int)i, 0);
+    for (unsigned int j = 0; j < matriz->colunas; ++j, ++pos) {
+        char c = origem[j];
+        if (c == '#') continue;
+        livre[pos >> 6] |= (uint64_t)1 << (pos & 63);
+        if (c == 'S') {
+            matriz->x_inicial = i;
+            matriz->y_inicial = j;
+        } else if (c == 'E') {
+            matriz->x_final = i;
+            matriz->y_final = j;
+        }
+    }
+}
+
+/* Monta, a partir do bitset, a tabela de vizinhança: para cada célula, os
+ * 4 bits baixos indicam as direções livres e os 4 bits altos guardam o grau
+ * (quantidade delas). */
+static int preparar_vizinhanca(Matriz *matriz) {
+    if (matriz->x_inicial == -1 || matriz->x_final == -1) {
+        printf("Pontos iniciais e/ou finais nao encontrados!\n");
+        return 0;
+    }
+    matriz->vizinhanca = calloc(matriz->total_celulas, 1);
+    if (!matriz->vizinhanca) {
+        printf("Erro ao alocar tabela de vizinhanca\n");
+        return 0;
+    }
+
+    ptrdiff_t passo[4];
+    passos_direcao(matriz, passo);
+    // A borda é sempre parede, então só o interior precisa ser visitado
+    for (int x = 0; x < (int)matriz->linhas; x++) {
+        ptrdiff_t pos = posicao_celula(matriz, x, 0);
+        for (int y = 0; y < (int)matriz->colunas; y++, pos++) {
+            unsigned char mascara = 0, grau = 0;
+            for (int d = 0; d < 4; d++) {
+                if (celula_livre(matriz, pos + passo[d])) {
+                    mascara |= (unsigned char)(1u << d);
+                    grau++;
+                }
+            }
+            matriz->vizinhanca[pos] = (unsigned char)(mascara | (grau << 4));
+        }
+    }
+    matriz->pos_inicial = posicao_celula(matriz, matriz->x_inicial, matriz->y_inicial);
+    matriz->pos_final = posicao_celula(matriz, matriz->x_final, matriz->y_final);
+    return 1;
+}
+
+int obter_vizinhos_validos(Matriz *matriz, int x, int y, Posicao *vizinhos, int max_vizinhos) {
+    unsigned char mascara = matriz->vizinhanca[posicao_celula(matriz, x, y)] & 0x0F;
+    int count = 0;
+    for (int d = 0; d < 4 && count < max_vizinhos; d++) {
+        if (mascara & (1u << d))
+            vizinhos[count++] = (Posicao){x + delta_x[d], y + delta_y[d]};
+    }
+    return count;
+}
+
+static Posicao passo_markov(Matriz *matriz, int x_atual, int y_atual, Gerador *gerador) {
+    unsigned char celula = matriz->vizinhanca[posicao_celula(matriz, x_atual, y_atual)];
+    int grau = celula >> 4;
+    if (grau == 0)
+        return (Posicao){x_atual, y_atual};
+    int d = escolha_vizinho[celula & 0x0F][gerador_intervalo(gerador, grau)];
+    return (Posicao){x_atual + delta_x[d], y_atual + delta_y[d]};
+}
+
+Posicao proximo_estado_markov(Matriz *matriz, int x_atual, int y_atual) {
+    return passo_markov(matriz, x_atual, y_atual, &gerador_global);
+}
+
+static void passeio_aleatorio(Matriz *matriz, No *no, int passeio_min, int passeio_max, Gerador *gerador) {
+    int max_tam = passeio_min + gerador_intervalo(gerador, passeio_max - passeio_min + 1);
+    if (max_tam > no->capacidade) max_tam = no->capacidade;
+    if (!no->genotipo && !no->genes) {
+        printf("Erro: individuo sem espaco para o genotipo.\n");
+        no->tam_genotipo = 0;
+        return;
+    }
+    no->num_pontos = 0;
+    ptrdiff_t passo[4];
+    passos_direcao(matriz, passo);
+    const unsigned char *vizinhanca = matriz->vizinhanca;
+    const ptrdiff_t destino = matriz->pos_final;
+
+    // Uma consulta à tabela por passo: grau e direções livres da célula atual
+    ptrdiff_t pos = matriz->pos_inicial;
+    int totalMov = 0;
+    uint64_t palavra = 0;
+    for (int i = 0; i < max_tam; i++) {
+        unsigned char celula = vizinhanca[pos];
+        int grau = celula >> 4;
+        if (grau == 0) break;
+
+        int d = escolha_vizinho[celula & 0x0F][gerador_intervalo(gerador, grau)];
+        if (no->genes) {
+            // Acumula 32 genes por palavra antes de gravar
+            palavra |= (uint64_t)d << ((totalMov & 31) * 2);
+            if ((totalMov & 31) == 31) {
+                no->genes[totalMov >> 5] = palavra;
+                palavra = 0;
+            }
+        } else {
+            no->genotipo[totalMov] = letra_vizinho[d];
+        }
+        totalMov++;
+        pos += passo[d];
+
+        if (pos == destino)
+            break;
+    }
+    if (no->genes && ((totalMov & 31) || totalMov == 0))
+        no->genes[totalMov >> 5] = palavra;
+    if (totalMov == 0) totalMov = 1; 
+    no->totalMov = totalMov;
+    no->tam_genotipo = totalMov;
+    no->x = (int)(pos / matriz->largura) - 1;
+    no->y = (int)(pos % matriz->largura) - 1;
+    no->colisoes = 0;
+}
+
+void cria_genotipo(Matriz *matriz, No *no) {
+    passeio_aleatorio(matriz, no, PASSEIO_MIN_PADRAO, PASSEIO_MAX_PADRAO, &gerador_global);
+}
+
+Matriz *criar_mapa(unsigned int linhas, unsigned int colunas, const char *celulas) {
+    if (!celulas || linhas == 0 || colunas == 0) return NULL;
+    Matriz *matriz = calloc(1, sizeof(Matriz));
+    if (!matriz) return NULL;
+    matriz->linhas = linhas;
+    matriz->colunas = colunas;
+    if (!preparar_livre(matriz)) {
+        liberar_matriz(matriz);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < linhas; ++i)
+        indexar_linha(matriz, i, celulas + (size_t)i * colunas);
+    if (!preparar_vizinhanca(matriz)) {
+        liberar_matriz(matriz);
+        return NULL;
+    }
+    return matriz;
+}
+
+/* Mapeia o arquivo inteiro na memória; se mmap() não for possível (por
+ * exemplo, em um pipe), lê o conteúdo para um buffer. */
+static int mapear_arquivo(Matriz *matriz, const char *arquivo) {
+    int fd = open(arquivo, O_RDONLY);
+    if (fd < 0) {
+        printf("Falha ao abrir arquivo %s\n", arquivo);
+        return 0;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void *regiao = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (regiao != MAP_FAILED) {
+            close(fd);
+            matriz->mapeamento = regiao;
+            matriz->tamanho_mapeamento = (size_t)info.st_size;
+            matriz->mapeado = 1;
+            return 1;
+        }
+    }
+
+    size_t capacidade = 1 << 16, tamanho = 0;
+    char *dados = malloc(capacidade);
+    ssize_t lidos = 0;
+    while (dados) {
+        lidos = read(fd, dados + tamanho, capacidade - tamanho);
+        if (lidos < 0 && errno == EINTR) continue;
+        if (lidos <= 0) break;
+        tamanho += (size_t)lidos;
+        if (tamanho == capacidade) {
+            capacidade *= 2;
+            char *maior = realloc(dados, capacidade);
+            if (!maior) free(dados);
+            dados = maior;
+        }
+    }
+    close(fd);
+    if (!dados || lidos < 0) {
+        printf("Erro ao ler o arquivo %s\n", arquivo);
+        free(dados);
+        return 0;
+    }
+    matriz->mapeamento = dados;
+    matriz->tamanho_mapeamento = tamanho;
+    matriz->mapeado = 0;
+    return 1;
+}
+
+static void desmapear_arquivo(Matriz *matriz) {
+    if (matriz->mapeado)
+        munmap(matriz->mapeamento, matriz->tamanho_mapeamento);
+    else
+        free(matriz->mapeamento);
+    free(matriz->inicio_linha);
+    matriz->mapeamento = NULL;
+    matriz->tamanho_mapeamento = 0;
+    matriz->mapeado = 0;
+    matriz->texto = NULL;
+    matriz->inicio_linha = NULL;
+}
+
+static int ler_dimensao(const char *texto, size_t tamanho, size_t *pos, unsigned int *valor) {
+    while (*pos < tamanho && (texto[*pos] == ' ' || texto[*pos] == '\t')) (*pos)++;
+    unsigned long long v = 0;
+    size_t inicio = *pos;
+    while (*pos < tamanho && texto[*pos] >= '0' && texto[*pos] <= '9' && v <= 0xFFFFFFFFull)
+        v = v * 10 + (unsigned)(texto[(*pos)++] - '0');
+    if (*pos == inicio || v == 0 || v > 0x7FFFFFFEull) return 0;
+    *valor = (unsigned int)v;
+    return 1;
+}
+
+/* Formato binário do mapa: o cabeçalho abaixo seguido das seções, cada uma
+ * alinhada em ALINHAMENTO_SECAO bytes para que possa ser usada direto dos
+ * bytes mapeados. Os inteiros ficam na ordem de bytes de quem gravou, que é
+ * conferida na leitura. O bitset `livre` e a tabela de vizinhança
+ * são gravados exatamente como ficam na memória (com a borda); a distância
+ * é um uint32_t por célula. Seções ausentes têm início 0. */
+#define ASSINATURA_MAPA "ALGMAPA\0"
+#define VERSAO_MAPA 1u
+#define ORDEM_BYTES_MAPA 0x01020304u
+#define ALINHAMENTO_SECAO 64
+#define DISTANCIA_INALCANCAVEL UINT32_MAX
+
+typedef struct _cabecalho_mapa {
+    char assinatura[8];
+    uint32_t versao;
+    uint32_t ordem_bytes;       /* ORDEM_BYTES_MAPA na ordem de quem gravou */
+    uint32_t linhas, colunas;
+    int32_t x_inicial, y_inicial;
+    int32_t x_final, y_final;
+    uint32_t secoes;            /* SecaoMapa presentes */
+    uint32_t reservado;
+    uint64_t inicio_livre;
+    uint64_t inicio_vizinhanca;
+    uint64_t inicio_distancia;
+} CabecalhoMapa;
+
+static inline size_t bytes_livre(const Matriz *matriz) {
+    return (matriz->total_celulas + 63) / 64 * sizeof(uint64_t);
+}
+
+/* Indica se um buffer da matriz aponta para dentro do arquivo mapeado (e,
+ * portanto, não deve ser liberado separadamente). */
+static int no_mapeamento(const Matriz *matriz, const void *p) {
+    const char *inicio = matriz->mapeamento;
+    return p && inicio && (const char *)p >= inicio && (const char *)p < inicio + matriz->tamanho_mapeamento;
+}
+
+/* Confere que a seção [inicio, inicio + bytes) cabe no arquivo e está alinhada. */
+static int secao_valida(uint64_t inicio, size_t bytes, size_t tamanho) {
+    return inicio >= sizeof(CabecalhoMapa) && inicio % ALINHAMENTO_SECAO == 0 &&
+           inicio <= tamanho && bytes <= tamanho - inicio;
+}
+
+/* Confere as seções de um mapa binário contra as regras que o passeio
+ * supõe: a borda é parede e, com `vizinhanca`, cada célula tem exatamente a
+ * entrada que preparar_vizinhanca() montaria a partir do bitset (a borda,
+ * zero). Um byte trocado levaria o passeio para fora do buffer. */
+static int conferir_mapa_binario(const Matriz *matriz, const unsigned char *vizinhanca) {
+    const ptrdiff_t largura = matriz->largura;
+    const ptrdiff_t ultima = (ptrdiff_t)matriz->total_celulas - largura;
+    for (ptrdiff_t y = 0; y < largura; y++) {
+        if (celula_livre(matriz, y) || celula_livre(matriz, ultima + y) ||
+            (vizinhanca && (vizinhanca[y] || vizinhanca[ultima + y])))
+            return 0;
+    }
+    for (ptrdiff_t inicio = largura; inicio < ultima; inicio += largura) {
+        const ptrdiff_t fim = inicio + largura - 1;
+        if (celula_livre(matriz, inicio) || celula_livre(matriz, fim) ||
+            (vizinhanca && (vizinhanca[inicio] || vizinhanca[fim])))
+            return 0;
+        if (!vizinhanca) continue;
+        // Mesma ordem de direções de passos_direcao()
+        for (ptrdiff_t pos = inicio + 1; pos < fim; pos++) {
+            unsigned int mascara = (unsigned int)celula_livre(matriz, pos - largura) |
+                                   (unsigned int)celula_livre(matriz, pos + largura) << 1 |
+                                   (unsigned int)celula_livre(matriz, pos - 1) << 2 |
+                                   (unsigned int)celula_livre(matriz, pos + 1) << 3;
+            unsigned int grau = (mascara & 1u) + (mascara >> 1 & 1u) + (mascara >> 2 & 1u) + (mascara >> 3);
+            if (vizinhanca[pos] != (unsigned char)(mascara | grau << 4)) return 0;
+        }
+    }
+    return 1;
+}
+
+/* Carrega um mapa no formato binário já mapeado em `matriz->mapeamento`:
+ * as seções são conferidas e usadas no lugar, sem cópia; a tabela de
+ * vizinhança só é montada se não estiver no arquivo. */
+static int carregar_mapa_binario(Matriz *matriz) {
+    const unsigned char *dados = matriz->mapeamento;
+    const size_t tamanho = matriz->tamanho_mapeamento;
+    CabecalhoMapa cabecalho;
+    memcpy(&cabecalho, dados, sizeof(cabecalho));
+    if (cabecalho.ordem_bytes != ORDEM_BYTES_MAPA || cabecalho.versao != VERSAO_MAPA) {
+        printf("Mapa binario com versao ou ordem de bytes incompativel\n");
+        return 0;
+    }
+    if (cabecalho.linhas == 0 || cabecalho.colunas == 0 ||
+        cabecalho.linhas > 0x7FFFFFFEu || cabecalho.colunas > 0x7FFFFFFEu) {
+        printf("Erro ao ler dimensoes da matriz\n");
+        return 0;
+    }
+    matriz->linhas = cabecalho.linhas;
+    matriz->colunas = cabecalho.colunas;
+    matriz->largura = (ptrdiff_t)matriz->colunas + 2;
+    matriz->total_celulas = ((size_t)matriz->linhas + 2) * (size_t)matriz->largura;
+
+    if (!secao_valida(cabecalho.inicio_livre, bytes_livre(matriz), tamanho) ||
+        ((cabecalho.secoes & MAPA_VIZINHANCA) &&
+         !secao_valida(cabecalho.inicio_vizinhanca, matriz->total_celulas, tamanho)) ||
+        ((cabecalho.secoes & MAPA_DISTANCIA) &&
+         !secao_valida(cabecalho.inicio_distancia, matriz->total_celulas * sizeof(uint32_t), tamanho))) {
+        printf("Mapa binario truncado ou corrompido\n");
+        return 0;
+    }
+    matriz->livre = (uint64_t *)(dados + cabecalho.inicio_livre);
+    const unsigned char *vizinhanca =
+        (cabecalho.secoes & MAPA_VIZINHANCA) ? dados + cabecalho.inicio_vizinhanca : NULL;
+    if (!conferir_mapa_binario(matriz, vizinhanca)) {
+        printf("Mapa binario truncado ou corrompido\n");
+        return 0;
+    }
+
+    if (cabecalho.x_inicial < 0 || cabecalho.y_inicial < 0 || cabecalho.x_final < 0 || cabecalho.y_final < 0 ||
+        (uint32_t)cabecalho.x_inicial >= cabecalho.linhas || (uint32_t)cabecalho.y_inicial >= cabecalho.colunas ||
+        (uint32_t)cabecalho.x_final >= cabecalho.linhas || (uint32_t)cabecalho.y_final >= cabecalho.colunas ||
+        !celula_livre(matriz, posicao_celula(matriz, cabecalho.x_inicial, cabecalho.y_inicial)) ||
+        !celula_livre(matriz, posicao_celula(matriz, cabecalho.x_final, cabecalho.y_final))) {
+        printf("Pontos iniciais e/ou finais nao encontrados!\n");
+        return 0;
+    }
+    matriz->x_inicial = cabecalho.x_inicial;
+    matriz->y_inicial = cabecalho.y_inicial;
+    matriz->x_final = cabecalho.x_final;
+    matriz->y_final = cabecalho.y_final;
+
+    if (cabecalho.secoes & MAPA_DISTANCIA)
+        matriz->distancia = (uint32_t *)(dados + cabecalho.inicio_distancia);
+    if (vizinhanca) {
+        matriz->vizinhanca = (unsigned char *)vizinhanca;
+        matriz->pos_inicial = posicao_celula(matriz, matriz->x_inicial, matriz->y_inicial);
+        matriz->pos_final = posicao_celula(matriz, matriz->x_final, matriz->y_final);
+        return 1;
+    }
+    return preparar_vizinhanca(matriz);
+}
+
+int calcular_distancias(Matriz *matriz) {
+    if (!matriz) return 0;
+    if (matriz->distancia) return 1;
+    uint32_t *distancia = malloc(matriz->total_celulas * sizeof(uint32_t));
+    size_t livres = 0;
+    for (size_t i = 0; i < bytes_livre(matriz) / sizeof(uint64_t); i++)
+        for (uint64_t w = matriz->livre[i]; w; w &= w - 1) livres++;
+    ptrdiff_t *fila = malloc(livres * sizeof(ptrdiff_t));
+    if (!distancia || !fila) {
+        printf("Erro ao alocar campo de distancias\n");
+        free(distancia);
+        free(fila);
+        return 0;
+    }
+    memset(distancia, 0xFF, matriz->total_celulas * sizeof(uint32_t));
+
+    // Busca em largura a partir do objetivo; os movimentos são simétricos
+    ptrdiff_t passo[4];
+    passos_direcao(matriz, passo);
+    size_t cabeca = 0, cauda = 0;
+    distancia[matriz->pos_final] = 0;
+    fila[cauda++] = matriz->pos_final;
+    while (cabeca < cauda) {
+        ptrdiff_t pos = fila[cabeca++];
+        unsigned char mascara = matriz->vizinhanca[pos] & 0x0F;
+        for (int d = 0; d < 4; d++) {
+            ptrdiff_t vizinho = pos + passo[d];
+            if ((mascara & (1u << d)) && distancia[vizinho] == DISTANCIA_INALCANCAVEL) {
+                distancia[vizinho] = distancia[pos] + 1;
+                fila[cauda++] = vizinho;
+            }
+        }
+    }
+    free(fila);
+    matriz->distancia = distancia;
+    return 1;
+}
+
+int distancia_objetivo(const Matriz *matriz, int x, int y) {
+    if (!matriz || !matriz->distancia || x < 0 || y < 0 ||
+        x >= (int)matriz->linhas || y >= (int)matriz->colunas) return -1;
+    uint32_t d = matriz->distancia[posicao_celula(matriz, x, y)];
+    return d == DISTANCIA_INALCANCAVEL || d > INT32_MAX ? -1 : (int)d;
+}
+
+static void liberar_cache(CacheFitness *cache) {
+    if (!cache) return;
+    free(cache->entradas);
+    free(cache);
+}
+
+/* Esvazia o cache; só pode ser chamada sem avaliações em andamento. */
+static void limpar_cache(CacheFitness *cache) {
+    if (!cache) return;
+    memset(cache->entradas, 0, (cache->mascara + 1) * sizeof(EntradaCache));
+}
+
+int definir_modo_fitness(Matriz *matriz, ModoFitness modo) {
+    if (!matriz || (modo != FITNESS_MANHATTAN && modo != FITNESS_CAMINHO)) return 0;
+    if (modo == FITNESS_CAMINHO && matriz->modo_fitness != FITNESS_CAMINHO) {
+        if (!calcular_distancias(matriz)) return 0;
+        // Células sem caminho até E pontuam depois de todas as que têm
+        uint32_t maxima = 0;
+        for (size_t i = 0; i < matriz->total_celulas; i++)
+            if (matriz->distancia[i] != DISTANCIA_INALCANCAVEL && matriz->distancia[i] > maxima)
+                maxima = matriz->distancia[i];
+        matriz->distancia_maxima = maxima;
+    }
+    // Os resultados guardados foram pontuados com a medida anterior
+    if (modo != matriz->modo_fitness) limpar_cache(matriz->cache);
+    matriz->modo_fitness = modo;
+    return 1;
+}
+
+ModoFitness modo_fitness(const Matriz *matriz) {
+    return matriz ? matriz->modo_fitness : FITNESS_MANHATTAN;
+}
+
+/* Grava `bytes` de `dados` a partir do próximo alinhamento, completando com
+ * zeros; `posicao` acompanha o deslocamento atual no arquivo. */
+static int gravar_secao(FILE *arquivo, const void *dados, size_t bytes, uint64_t *posicao, uint64_t *inicio) {
+    static const unsigned char zeros[ALINHAMENTO_SECAO];
+    size_t preenchimento = (size_t)((ALINHAMENTO_SECAO - *posicao % ALINHAMENTO_SECAO) % ALINHAMENTO_SECAO);
+    if (fwrite(zeros, 1, preenchimento, arquivo) != preenchimento) return 0;
+    *inicio = *posicao + preenchimento;
+    *posicao = *inicio + bytes;
+    return fwrite(dados, 1, bytes, arquivo) == bytes;
+}
+
+int salvar_mapa_binario(Matriz *matriz, const char *arquivo, int secoes) {
+    if (!matriz || !arquivo) return 0;
+    if ((secoes & MAPA_DISTANCIA) && !calcular_distancias(matriz)) return 0;
+
+    CabecalhoMapa cabecalho;
+    memset(&cabecalho, 0, sizeof(cabecalho));
+    memcpy(cabecalho.assinatura, ASSINATURA_MAPA, sizeof(cabecalho.assinatura));
+    cabecalho.versao = VERSAO_MAPA;
+    cabecalho.ordem_bytes = ORDEM_BYTES_MAPA;
+    cabecalho.linhas = matriz->linhas;
+    cabecalho.colunas = matriz->colunas;
+    cabecalho.x_inicial = matriz->x_inicial;
+    cabecalho.y_inicial = matriz->y_inicial;
+    cabecalho.x_final = matriz->x_final;
+    cabecalho.y_final = matriz->y_final;
+    cabecalho.secoes = (uint32_t)secoes & (MAPA_VIZINHANCA | MAPA_DISTANCIA);
+
+    FILE *saida = fopen(arquivo, "wb");
+    if (!saida) {
+        printf("Falha ao abrir arquivo %s\n", arquivo);
+        return 0;
+    }
+    // O cabeçalho é gravado duas vezes: antes, para reservar o espaço, e no
+    // fim, já com o início de cada seção
+    uint64_t posicao = sizeof(cabecalho);
+    int ok = fwrite(&cabecalho, sizeof(cabecalho), 1, saida) == 1 &&
+             gravar_secao(saida, matriz->livre, bytes_livre(matriz), &posicao, &cabecalho.inicio_livre);
+    if (ok && (cabecalho.secoes & MAPA_VIZINHANCA))
+        ok = gravar_secao(saida, matriz->vizinhanca, matriz->total_celulas, &posicao, &cabecalho.inicio_vizinhanca);
+    if (ok && (cabecalho.secoes & MAPA_DISTANCIA))
+        ok = gravar_secao(saida, matriz->distancia, matriz->total_celulas * sizeof(uint32_t), &posicao,
+                          &cabecalho.inicio_distancia);
+    ok = ok && fseek(saida, 0, SEEK_SET) == 0 && fwrite(&cabecalho, sizeof(cabecalho), 1, saida) == 1;
+    if (fclose(saida) != 0) ok = 0;
+    if (!ok) printf("Erro ao gravar o mapa binario %s\n", arquivo);
+    return ok;
+}
+
+Matriz *carregar_mapa(const char *arquivo) {
+    Matriz *matriz = calloc(1, sizeof(Matriz));
+    if (!matriz) return NULL;
+    if (!mapear_arquivo(matriz, arquivo)) {
+        free(matriz);
+        return NULL;
+    }
+    const char *texto = matriz->mapeamento;
+    const size_t tamanho = matriz->tamanho_mapeamento;
+
+    if (tamanho >= sizeof(CabecalhoMapa) && memcmp(texto, ASSINATURA_MAPA, 8) == 0) {
+#ifdef MADV_WILLNEED
+        if (matriz->mapeado) madvise(matriz->mapeamento, tamanho, MADV_WILLNEED);
+#endif
+        if (!carregar_mapa_binario(matriz)) {
+            liberar_matriz(matriz);
+            return NULL;
+        }
+        return matriz;
+    }
+#ifdef MADV_SEQUENTIAL
+    if (matriz->mapeado) madvise(matriz->mapeamento, tamanho, MADV_SEQUENTIAL);
+#endif
+
+    size_t pos = 0;
+    if (!ler_dimensao(texto, tamanho, &pos, &matriz->linhas) || !ler_dimensao(texto, tamanho, &pos, &matriz->colunas)) {
+        printf("Erro ao ler dimensoes da matriz\n");
+        liberar_matriz(matriz);
+        return NULL;
+    }
+    // O resto da linha do cabeçalho é ignorado
+    const char *fim = memchr(texto + pos, '\n', tamanho - pos);
+    pos = fim ? (size_t)(fim - texto) + 1 : tamanho;
+
+    matriz->inicio_linha = malloc((size_t)matriz->linhas * sizeof(size_t));
+    if (!matriz->inicio_linha || !preparar_livre(matriz)) {
+        printf("Erro na alocacao do mapa\n");
+        liberar_matriz(matriz);
+        return NULL;
+    }
+
+    // Uma passada: localiza cada linha (LF ou CRLF), marca as células livres e acha S e E
+    for (unsigned int i = 0; i < matriz->linhas; ++i) {
+        if (pos >= tamanho) {
+            printf("Erro ao ler linha %u\n", i);
+            liberar_matriz(matriz);
+            return NULL;
+        }
+        fim = memchr(texto + pos, '\n', tamanho - pos);
+        size_t largura = (fim ? (size_t)(fim - texto) : tamanho) - pos;
+        if (largura > 0 && texto[pos + largura - 1] == '\r') largura--;
+        if (largura < matriz->colunas) {
+            printf("Linha %u tem %zu colunas, esperadas %u\n", i, largura, matriz->colunas);
+            liberar_matriz(matriz);
+            return NULL;
+        }
+        matriz->inicio_linha[i] = pos;
+        indexar_linha(matriz, i, texto + pos);
+        pos = fim ? (size_t)(fim - texto) + 1 : tamanho;
+    }
+    matriz->texto = texto;
+
+    if (!preparar_vizinhanca(matriz)) {
+        liberar_matriz(matriz);
+        return NULL;
+    }
+    return matriz;
+}
+
+char celula_mapa(const Matriz *matriz, int x, int y) {
+    if (!matriz || x < 0 || y < 0 || x >= (int)matriz->linhas || y >= (int)matriz->colunas) return '#';
+    if (matriz->texto)
+        return matriz->texto[matriz->inicio_linha[x] + (size_t)y];
+    // Sem o texto, a célula é reconstruída do bitset
+    if (x == matriz->x_inicial && y == matriz->y_inicial) return 'S';
+    if (x == matriz->x_final && y == matriz->y_final) return 'E';
+    return celula_livre(matriz, posicao_celula(matriz, x, y)) ? ' ' : '#';
+}
+
+void imprimir(Lista *lista) {
+    if (!lista || lista->atual.quantidade == 0) {
+        printf("Lista vazia.\n");
+        return;
+    }
+    printf("Individuos:\n");
+    for (int k = 0; k < lista->atual.quantidade; k++) {
+        No *atual = &lista->atual.individuos[k];
+        printf("Genotipo: ");
+        for (int i = 0; i < atual->tam_genotipo; i++)
+            printf("%c", letra_gene(atual, i));
+        printf("\nFitness: %.2f\nCoordenada final (%d, %d)\n", atual->fitness, atual->x, atual->y);
+        printf("------------------------------\n");
+    }
+}
+
+/* Avaliador usado pelas funções seriais, criado no primeiro uso. */
+static Avaliador *avaliador_da_matriz(Matriz *matriz) {
+    if (!matriz->avaliador)
+        matriz->avaliador = cria_avaliador(matriz);
+    return matriz->avaliador;
+}
+
+Configuracao configuracao_padrao(void) {
+    Configuracao config;
+    config.tamanho_populacao = POPULACAO_PADRAO;
+    config.elite = ELITE_PADRAO;
+    config.max_filhos = MAX_FILHOS_PADRAO;
+    config.taxa_mutacao = TAXA_MUTACAO_PADRAO;
+    config.tam_filho = TAM_FILHO_PADRAO;
+    config.passeio_min = PASSEIO_MIN_PADRAO;
+    config.passeio_max = PASSEIO_MAX_PADRAO;
+    config.genoma_compacto = 0;
+    config.modo_fitness = FITNESS_MANHATTAN;
+    config.selecao = SELECAO_VIZINHOS;
+    config.tamanho_torneio = TAMANHO_TORNEIO_PADRAO;
+    config.pressao_ranking = PRESSAO_RANKING_PADRAO;
+    config.crossover = CROSSOVER_METADES;
+    config.lote_estacionario = 0;
+    config.arquivo_lote = NULL;
+    config.arquivo_resumo = NULL;
+    config.cache_fitness = CACHE_FITNESS_PADRAO;
+    config.geracoes = GERACOES_PADRAO;
+    config.threads = 1;
+    config.semente = 0;
+    config.arquivo_mapa = "matriz.txt";
+    config.arquivo_saida = "resultado.csv";
+    config.arquivo_telemetria = NULL;
+    config.telemetria_json = 0;
+    config.ilhas = 1;
+    config.intervalo_migracao = INTERVALO_MIGRACAO_PADRAO;
+    config.migrantes = MIGRANTES_PADRAO;
+    config.trabalhadores = NULL;
+    config.trabalhadores_locais = 0;
+    config.endereco_servico = NULL;
+    config.arquivo_binario = NULL;
+    config.binario_sem_metadados = 0;
+    config.arquivo_populacoes = NULL;
+    config.populacoes_binario = 0;
+    config.comprimir_populacoes = 0;
+    config.fila_populacoes = FILA_POPULACOES_PADRAO;
+    config.descartar_populacoes = 0;
+    config.arquivo_descomprimir = NULL;
+    config.arquivo_estado = NULL;
+    config.intervalo_estado = INTERVALO_ESTADO_PADRAO;
+    config.arquivo_retomada = NULL;
+    config.parar_no_objetivo = 0;
+    config.geracoes_sem_melhora = 0;
+    config.tempo_limite = 0.0;
+    config.max_avaliacoes = 0;
+    config.mutacao_adaptativa = 0;
+    config.populacao_minima = 0;
+    return config;
+}
+
+int validar_configuracao(const Configuracao *config) {
+    if (!config) return 0;
+    if (config->tamanho_populacao < 1) {
+        printf("Tamanho da populacao deve ser positivo\n");
+        return 0;
+    }
+    if (config->elite < 0 || config->elite > config->tamanho_populacao) {
+        printf("Elite deve estar entre 0 e o tamanho da populacao\n");
+        return 0;
+    }
+    if (config->max_filhos < 0) {
+        printf("Numero maximo de filhos nao pode ser negativo\n");
+        return 0;
+    }
+    if (!(config->taxa_mutacao >= 0.0f && config->taxa_mutacao <= 1.0f)) {
+        printf("Taxa de mutacao deve estar entre 0 e 1\n");
+        return 0;
+    }
+    if (config->tam_filho < 1) {
+        printf("Tamanho do genotipo dos filhos deve ser positivo\n");
+        return 0;
+    }
+    if (config->passeio_min < 1 || config->passeio_max < config->passeio_min) {
+        printf("Comprimentos do passeio aleatorio invalidos (%d a %d)\n",
+               config->passeio_min, config->passeio_max);
+        return 0;
+    }
+    if (config->modo_fitness != FITNESS_MANHATTAN && config->modo_fitness != FITNESS_CAMINHO) {
+        printf("Modo de fitness invalido\n");
+        return 0;
+    }
+    if (config->selecao < SELECAO_VIZINHOS || config->selecao > SELECAO_RANKING) {
+        printf("Operador de selecao invalido\n");
+        return 0;
+    }
+    if (config->tamanho_torneio < 1 || !(config->pressao_ranking >= 1.0f && config->pressao_ranking <= 2.0f)) {
+        printf("Tamanho do torneio ou pressao do ranking invalidos\n");
+        return 0;
+    }
+    if (config->crossover < CROSSOVER_METADES || config->crossover > CROSSOVER_POSICIONAL) {
+        printf("Operador de crossover invalido\n");
+        return 0;
+    }
+    if (config->lote_estacionario < 0) {
+        printf("Lote do modo estacionario invalido\n");
+        return 0;
+    }
+    if (config->lote_estacionario > 0 && (config->trabalhadores || config->trabalhadores_locais > 0 ||
+                                          config->populacao_minima > 0)) {
+        printf("O modo estacionario nao e suportado com avaliacao distribuida nem com populacao minima\n");
+        return 0;
+    }
+    if (config->arquivo_lote && (config->ilhas > 1 || config->trabalhadores || config->trabalhadores_locais > 0 ||
+                                 config->endereco_servico || config->arquivo_binario || config->arquivo_populacoes ||
+                                 config->arquivo_estado || config->arquivo_retomada || config->arquivo_telemetria)) {
+        printf("O modo em lote nao e suportado com ilhas, avaliacao distribuida, conversao, populacoes, estado ou telemetria\n");
+        return 0;
+    }
+    if (config->cache_fitness < 0) {
+        printf("Tamanho do cache de fitness invalido\n");
+        return 0;
+    }
+    if (config->geracoes < 0 || config->threads < 1) {
+        printf("Numero de geracoes ou de threads invalido\n");
+        return 0;
+    }
+    if (config->trabalhadores_locais < 0) {
+        printf("Numero de trabalhadores locais invalido\n");
+        return 0;
+    }
+    if (config->ilhas < 1 || config->intervalo_migracao < 0 || config->migrantes < 0) {
+        printf("Parametros de ilhas e migracao invalidos\n");
+        return 0;
+    }
+    if (config->ilhas > 1 && (config->arquivo_populacoes || config->arquivo_estado || config->arquivo_retomada)) {
+        printf("Gravacao das populacoes e do estado nao e suportada com ilhas\n");
+        return 0;
+    }
+    if (config->fila_populacoes < 1) {
+        printf("A fila de populacoes precisa de pelo menos um espaco\n");
+        return 0;
+    }
+    if (config->intervalo_estado < 0) {
+        printf("Intervalo de salvamento do estado invalido\n");
+        return 0;
+    }
+    if (config->geracoes_sem_melhora < 0 || !(config->tempo_limite >= 0.0)) {
+        printf("Criterios de parada invalidos\n");
+        return 0;
+    }
+    if (config->populacao_minima != 0 &&
+        (config->populacao_minima < 1 || config->populacao_minima < config->elite ||
+         config->populacao_minima > config->tamanho_populacao)) {
+        printf("Populacao minima deve estar entre a elite e o tamanho da populacao\n");
+        return 0;
+    }
+    return 1;
+}
+
+/* Maior genótipo que a população pode conter: filhos ou passeios. */
+static int tam_max_genotipo(const Configuracao *config) {
+    return config->tam_filho > config->passeio_max ? config->tam_filho : config->passeio_max;
+}
+
+Lista *cria_lista_configurada(const Configuracao *config) {
+    if (!validar_configuracao(config)) return NULL;
+    Lista *lista = calloc(1, sizeof(Lista));
+    if (!lista) return NULL;
+    lista->config = *config;
+    lista->atual.compacta = lista->reserva.compacta = config->genoma_compacto ? 1 : 0;
+    lista->atual.tam_max = lista->reserva.tam_max = tam_max_genotipo(config);
+    return lista;
+}
+
+Lista *cria_lista() {
+    Configuracao config = configuracao_padrao();
+    return cria_lista_configurada(&config);
+}
+
+Lista *cria_lista_compacta(void) {
+    Configuracao config = configuracao_padrao();
+    config.genoma_compacto = 1;
+    return cria_lista_configurada(&config);
+}
+
+static int arena_insere_elementos(Arena *arena, Matriz *matriz, int num_elementos, const Configuracao *config,
+                                  Gerador *gerador, Avaliador *avaliador) {
+    if (!arena_reservar(arena, arena->quantidade + num_elementos)) {
+        printf("Erro ao reservar espaco para %d individuos\n", num_elementos);
+        return 0;
+    }
+    for (int i = 0; i < num_elementos; ++i) {
+        No *node = arena_novo_individuo(arena);
+        passeio_aleatorio(matriz, node, config->passeio_min, config->passeio_max, gerador);
+        node->fitness = avaliar_individuo(avaliador, node);
+    }
+    return 1;
+}
+
+void insere_elementos(Lista *lista, Matriz *matriz, int num_elementos) {
+    if (!lista || !matriz) return;
+    Avaliador *avaliador = avaliador_da_matriz(matriz);
+    if (!avaliador) return;
+    arena_insere_elementos(&lista->atual, matriz, num_elementos, &lista->config, &gerador_global, avaliador);
+}
+
+Avaliador *cria_avaliador(Matriz *matriz) {
+    if (!matriz) return NULL;
+    Avaliador *avaliador = malloc(sizeof(Avaliador));
+    if (!avaliador) return NULL;
+    avaliador->matriz = matriz;
+    avaliador->marcas = calloc(matriz->total_celulas, sizeof(unsigned int));
+    if (!avaliador->marcas) {
+        printf("Erro ao alocar visitas\n");
+        free(avaliador);
+        return NULL;
+    }
+    avaliador->rodada = 0;
+    avaliador->marcas_lote = NULL;
+    avaliador->rodada_lote = 0;
+    avaliador->passos_lote = NULL;
+    avaliador->capacidade_passos = 0;
+    avaliador->indices_cruzamento = NULL;
+    avaliador->capacidade_celulas = matriz->total_celulas;
+    return avaliador;
+}
+
+void liberar_avaliador(Avaliador *avaliador) {
+    if (!avaliador) return;
+    free(avaliador->marcas);
+    free(avaliador->marcas_lote);
+    free(avaliador->passos_lote);
+    free(avaliador->indices_cruzamento);
+    free(avaliador);
+}
+
+static inline float pontuacao(const Matriz *matriz, ptrdiff_t pos, int colisoes, int repeticoes, int totalMov) {
+    int x = (int)(pos / matriz->largura) - 1;
+    int y = (int)(pos % matriz->largura) - 1;
+
+    float distancia = fabsf(x - matriz->x_final) + fabsf(y - matriz->y_final);
+    float penalidade_colisao = 5.0f * colisoes;
+    float penalidade_repetida = 3.0f * repeticoes;
+
+    if (matriz->modo_fitness == FITNESS_CAMINHO) {
+        // Distância pelo labirinto, em uma consulta ao campo pré-calculado.
+        // Como ela já mede o progresso real, não há recompensa por comprimento,
+        // que em modo Manhattan abafaria o termo de distância.
+        uint32_t passos = matriz->distancia[pos];
+        distancia = passos != DISTANCIA_INALCANCAVEL ? (float)passos
+                                                     : (float)matriz->distancia_maxima + 1.0f + distancia;
+        return 1000.0f - PESO_DISTANCIA_CAMINHO * distancia - penalidade_colisao - penalidade_repetida;
+    }
+    // O quadrado é feito em float porque em int transbordaria a partir de
+    // 46341 movimentos; abaixo disso o resultado é o mesmo
+    float movimentos = (float)totalMov;
+    float recompensa_comprimento = 10.0f * movimentos + 0.1f * (movimentos * movimentos);
+
+    return 1000.0f - distancia - penalidade_colisao - penalidade_repetida + recompensa_comprimento;
+}
+
+/* Um passo do percurso de avaliação; retorna 0 quando o percurso termina
+ * (colisão ou chegada ao destino). */
+static inline int avancar_avaliacao(const Matriz *matriz, unsigned int *marcas, unsigned int rodada,
+                                    ptrdiff_t *pos, ptrdiff_t passo, int *colisoes, int *repeticoes) {
+    ptrdiff_t novo = *pos + passo;
+    if (!celula_livre(matriz, novo)) {
+        (*colisoes)++;
+        return 0;
+    }
+    *pos = novo;
+    // Revisitar uma célula já carimbada equivale a uma repetição
+    if (marcas[novo] == rodada)
+        (*repeticoes)++;
+    else
+        marcas[novo] = rodada;
+    return novo != matriz->pos_final;
+}
+
+float avaliar_individuo(Avaliador *avaliador, No *no) {
+    const Matriz *matriz = avaliador->matriz;
+    unsigned int *marcas = avaliador->marcas;
+
+    // Cada avaliação usa um carimbo novo; só no estouro o buffer é zerado
+    if (++avaliador->rodada == 0) {
+        memset(marcas, 0, matriz->total_celulas * sizeof(unsigned int));
+        avaliador->rodada = 1;
+    }
+    const unsigned int rodada = avaliador->rodada;
+
+    ptrdiff_t passo[5];
+    passo[0] = 0;
+    passos_direcao(matriz, passo + 1);
+
+    ptrdiff_t pos = matriz->pos_inicial;
+    marcas[pos] = rodada;
+    int colisoes = 0;
+    int penalidade_repeticao = 0;
+    if (no->genes) {
+        // Decodifica uma palavra (32 movimentos) por vez
+        for (int w = 0; w * 32 < no->tam_genotipo; w++) {
+            uint64_t palavra = no->genes[w];
+            int fim = no->tam_genotipo - w * 32 < 32 ? no->tam_genotipo - w * 32 : 32;
+            for (int j = 0; j < fim; j++, palavra >>= 2) {
+                if (!avancar_avaliacao(matriz, marcas, rodada, &pos, passo[1 + (palavra & 3u)],
+                                       &colisoes, &penalidade_repeticao))
+                    goto fim_percurso;
+            }
+        }
+    } else {
+        for (int i = 0; i < no->tam_genotipo; i++) {
+            if (!avancar_avaliacao(matriz, marcas, rodada, &pos, passo[codigo_letra[(unsigned char)no->genotipo[i]]],
+                                   &colisoes, &penalidade_repeticao))
+                break;
+        }
+    }
+fim_percurso:
+    return pontuacao(matriz, pos, colisoes, penalidade_repeticao, no->totalMov);
+}
+
+float calcula_fitness(Matriz *matriz, No *no) {
+    Avaliador *avaliador = avaliador_da_matriz(matriz);
+    if (!avaliador) return -INFINITY;
+    return avaliar_individuo(avaliador, no);
+}
+
+static inline int avancar_caminho(const Matriz *matriz, ptrdiff_t *pos, ptrdiff_t passo, int *colisoes) {
+    ptrdiff_t novo = *pos + passo;
+    // A borda de paredes faz sair do mapa contar como colisão
+    if (!celula_livre(matriz, novo)) {
+        (*colisoes)++;
+        return 0;
+    }
+    *pos = novo;
+    return 1;
+}
+
+/* Percorre o genótipo a partir do início até a primeira colisão ou a chegada
+ * ao destino; retorna o número de movimentos válidos e a posição final. */
+static int decodificar_caminho(const Matriz *matriz, const No *no, ptrdiff_t *pos_final, int *colisoes) {
+    ptrdiff_t passo[5];
+    passo[0] = 0;
+    passos_direcao(matriz, passo + 1);
+
+    ptrdiff_t pos = matriz->pos_inicial;
+    int mov_validos = 0;
+    if (no->genes) {
+        for (int w = 0; w * 32 < no->tam_genotipo; w++) {
+            uint64_t palavra = no->genes[w];
+            int fim = no->tam_genotipo - w * 32 < 32 ? no->tam_genotipo - w * 32 : 32;
+            for (int j = 0; j < fim; j++, palavra >>= 2) {
+                if (!avancar_caminho(matriz, &pos, passo[1 + (palavra & 3u)], colisoes))
+                    goto fim_percurso;
+                mov_validos++;
+                if (pos == matriz->pos_final) goto fim_percurso;
+            }
+        }
+    } else {
+        for (int i = 0; i < no->tam_genotipo; i++) {
+            if (!avancar_caminho(matriz, &pos, passo[codigo_letra[(unsigned char)no->genotipo[i]]], colisoes))
+                break;
+            mov_validos++;
+            if (pos == matriz->pos_final) break;
+        }
+    }
+fim_percurso:
+    *pos_final = pos;
+    return mov_validos;
+}
+
+#define LARGURA_LOTE 8
+
+static int preparar_lote(Avaliador *avaliador, int passos) {
+    if (!avaliador->marcas_lote) {
+        avaliador->marcas_lote = calloc(avaliador->matriz->total_celulas, sizeof(uint32_t));
+        if (!avaliador->marcas_lote) {
+            printf("Erro ao alocar visitas do lote\n");
+            return 0;
+        }
+    }
+    if (passos > avaliador->capacidade_passos) {
+        int32_t *novos = realloc(avaliador->passos_lote, (size_t)passos * LARGURA_LOTE * sizeof(int32_t));
+        if (!novos) {
+            printf("Erro ao alocar passos do lote\n");
+            return 0;
+        }
+        avaliador->passos_lote = novos;
+        avaliador->capacidade_passos = passos;
+    }
+    return 1;
+}
+
+/* Marca a visita da pista à célula; cada pista tem seu bit dentro do carimbo. */
+static inline void marcar_lote(uint32_t *marcas, uint32_t rodada, int32_t pos, int pista, int32_t *repeticoes) {
+    uint32_t valor = marcas[pos];
+    if ((valor >> 8) != rodada)
+        valor = rodada << 8;
+    if (valor & (1u << pista))
+        repeticoes[pista]++;
+    else
+        valor |= 1u << pista;
+    marcas[pos] = valor;
+}
+
+#if defined(__AVX2__)
+static void percorrer_lote(const Matriz *matriz, const int32_t *passos, int maior, const int32_t *tam,
+                           int32_t *pos, int32_t *movimentos, int32_t *colisoes, int32_t *repeticoes,
+                           uint32_t *marcas, uint32_t rodada) {
+    const int *livre = (const int *)matriz->livre;
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i um = _mm256_set1_epi32(1);
+    const __m256i trinta_e_um = _mm256_set1_epi32(31);
+    const __m256i destino = _mm256_set1_epi32((int32_t)matriz->pos_final);
+    const __m256i vtam = _mm256_loadu_si256((const __m256i *)tam);
+    __m256i vpos = _mm256_loadu_si256((const __m256i *)pos);
+    __m256i vmov = zero, vcol = zero;
+    __m256i vivas = _mm256_cmpgt_epi32(vtam, zero);
+
+    for (int i = 0; i < maior; i++) {
+        vivas = _mm256_and_si256(vivas, _mm256_cmpgt_epi32(vtam, _mm256_set1_epi32(i)));
+        if (_mm256_testz_si256(vivas, vivas)) break;
+
+        // Coleta a palavra de 32 bits do bitset de cada pista e testa o bit da nova célula
+        __m256i novo = _mm256_add_epi32(vpos, _mm256_loadu_si256((const __m256i *)(passos + (size_t)i * LARGURA_LOTE)));
+        __m256i palavras = _mm256_mask_i32gather_epi32(zero, livre, _mm256_srli_epi32(novo, 5), vivas, 4);
+        __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(palavras, _mm256_and_si256(novo, trinta_e_um)), um);
+        __m256i livres = _mm256_cmpeq_epi32(bit, um);
+        __m256i mover = _mm256_and_si256(vivas, livres);
+
+        vcol = _mm256_sub_epi32(vcol, _mm256_andnot_si256(livres, vivas));
+        vmov = _mm256_sub_epi32(vmov, mover);
+        vpos = _mm256_blendv_epi8(vpos, novo, mover);
+        vivas = _mm256_andnot_si256(_mm256_cmpeq_epi32(novo, destino), mover);
+
+        // As marcas de repetição exigem leitura e escrita por pista
+        int pistas = _mm256_movemask_ps(_mm256_castsi256_ps(mover));
+        if (pistas) {
+            _mm256_storeu_si256((__m256i *)pos, vpos);
+            for (; pistas; pistas &= pistas - 1) {
+                int pista = __builtin_ctz((unsigned int)pistas);
+                marcar_lote(marcas, rodada, pos[pista], pista, repeticoes);
+            }
+        }
+    }
+    _mm256_storeu_si256((__m256i *)pos, vpos);
+    _mm256_storeu_si256((__m256i *)movimentos, vmov);
+    _mm256_storeu_si256((__m256i *)colisoes, vcol);
+}
+#else
+static void percorrer_lote(const Matriz *matriz, const int32_t *passos, int maior, const int32_t *tam,
+                           int32_t *pos, int32_t *movimentos, int32_t *colisoes, int32_t *repeticoes,
+                           uint32_t *marcas, uint32_t rodada) {
+    unsigned int vivas = 0;
+    for (int pista = 0; pista < LARGURA_LOTE; pista++)
+        if (tam[pista] > 0) vivas |= 1u << pista;
+
+    for (int i = 0; i < maior && vivas; i++) {
+        const int32_t *linha = passos + (size_t)i * LARGURA_LOTE;
+        for (int pista = 0; pista < LARGURA_LOTE; pista++) {
+            const unsigned int bit = 1u << pista;
+            if (!(vivas & bit)) continue;
+            if (i >= tam[pista]) {
+                vivas &= ~bit;
+                continue;
+            }
+            int32_t novo = pos[pista] + linha[pista];
+            if (!celula_livre(matriz, novo)) {
+                colisoes[pista]++;
+                vivas &= ~bit;
+                continue;
+            }
+            pos[pista] = novo;
+            movimentos[pista]++;
+            marcar_lote(marcas, rodada, novo, pista, repeticoes);
+            if (novo == matriz->pos_final)
+                vivas &= ~bit;
+        }
+    }
+}
+#endif
+
+/* Caminho individual equivalente a avaliar_bloco(), usado quando o mapa é
+ * grande demais para posições de 32 bits ou faltou memória para o lote. */
+static void avaliar_sozinho(Avaliador *avaliador, No *no, int truncar) {
+    const Matriz *matriz = avaliador->matriz;
+    ptrdiff_t pos;
+    int colisoes = 0;
+    int movimentos = decodificar_caminho(matriz, no, &pos, &colisoes);
+    if (truncar) {
+        no->tam_genotipo = movimentos;
+        no->totalMov = movimentos;
+    }
+    no->x = (int)(pos / matriz->largura) - 1;
+    no->y = (int)(pos % matriz->largura) - 1;
+    no->colisoes = colisoes;
+    no->fitness = avaliar_individuo(avaliador, no);
+}
+
+/* Refaz as marcas de visita dos `n` primeiros movimentos da pista sem testar
+ * paredes nem contar repetições: o ponto de retomada garante que eles são
+ * válidos, e as repetições até ali já estão nele. */
+static void remarcar_prefixo(const Matriz *matriz, const No *no, int n, const ptrdiff_t *passo,
+                             uint32_t *marcas, uint32_t rodada, int pista) {
+    const uint32_t bit = 1u << pista, novo = rodada << 8;
+    int32_t pos = (int32_t)matriz->pos_inicial;
+    marcas[pos] = ((marcas[pos] >> 8) == rodada ? marcas[pos] : novo) | bit;
+    for (int i = 0; i < n; i++) {
+        int codigo = no->genes ? 1 + gene_compacto(no->genes, i) : codigo_letra[(unsigned char)no->genotipo[i]];
+        pos += (int32_t)passo[codigo];
+        uint32_t valor = marcas[pos];
+        marcas[pos] = ((valor >> 8) == rodada ? valor : novo) | bit;
+    }
+}
+
+/* Avalia até LARGURA_LOTE indivíduos percorrendo seus caminhos lado a lado.
+ * Com `truncar`, cada genótipo é cortado no primeiro movimento inválido ou na
+ * chegada (como na decodificação dos filhos) e o fitness é o do caminho
+ * cortado, evitando o segundo percurso. Cada pista continua do último ponto
+ * de retomada do seu nó (um filho herda os do prefixo do pai) e o percurso
+ * anda em trechos de INTERVALO_RETOMADA movimentos, gravando um novo ponto
+ * ao fim de cada trecho completo. */
+static void avaliar_bloco(Avaliador *avaliador, No *const *nos, int n, int truncar) {
+    const Matriz *matriz = avaliador->matriz;
+    int32_t inicio[LARGURA_LOTE] = {0}, tam[LARGURA_LOTE] = {0};
+    int maior = 0;
+    for (int pista = 0; pista < n; pista++) {
+        const No *no = nos[pista];
+        if (no->pontos && no->num_pontos > 0) inicio[pista] = no->num_pontos * INTERVALO_RETOMADA;
+        tam[pista] = no->tam_genotipo - inicio[pista];
+        if (tam[pista] > maior) maior = tam[pista];
+    }
+
+    if (matriz->total_celulas > (size_t)INT32_MAX || !preparar_lote(avaliador, maior)) {
+        for (int pista = 0; pista < n; pista++)
+            avaliar_sozinho(avaliador, nos[pista], truncar);
+        return;
+    }
+    if (++avaliador->rodada_lote > 0xFFFFFFu) {
+        memset(avaliador->marcas_lote, 0, matriz->total_celulas * sizeof(uint32_t));
+        avaliador->rodada_lote = 1;
+    }
+    const uint32_t rodada = avaliador->rodada_lote;
+
+    ptrdiff_t passo[5];
+    passo[0] = 0;
+    passos_direcao(matriz, passo + 1);
+
+    // Transpõe os genótipos a partir da retomada: o passo i de todas as pistas fica contíguo
+    int32_t *passos = avaliador->passos_lote;
+    int32_t pos[LARGURA_LOTE];
+    int32_t movimentos[LARGURA_LOTE] = {0}, colisoes[LARGURA_LOTE] = {0}, repeticoes[LARGURA_LOTE] = {0};
+    for (int pista = 0; pista < LARGURA_LOTE; pista++) {
+        pos[pista] = (int32_t)matriz->pos_inicial;
+        int i = 0;
+        if (pista < n) {
+            const No *no = nos[pista];
+            const int de = inicio[pista];
+            if (no->genes) {
+                for (; i < tam[pista]; i++)
+                    passos[(size_t)i * LARGURA_LOTE + pista] = (int32_t)passo[1 + gene_compacto(no->genes, de + i)];
+            } else {
+                for (; i < tam[pista]; i++)
+                    passos[(size_t)i * LARGURA_LOTE + pista] = (int32_t)passo[codigo_letra[(unsigned char)no->genotipo[de + i]]];
+            }
+            if (de > 0) {
+                const PontoRetomada *ponto = &no->pontos[no->num_pontos - 1];
+                remarcar_prefixo(matriz, no, de, passo, avaliador->marcas_lote, rodada, pista);
+                pos[pista] = ponto->pos;
+                repeticoes[pista] = ponto->repeticoes;
+                movimentos[pista] = de;
+            } else {
+                marcar_lote(avaliador->marcas_lote, rodada, pos[pista], pista, repeticoes);
+            }
+        }
+        for (; i < maior; i++)
+            passos[(size_t)i * LARGURA_LOTE + pista] = 0;
+    }
+
+    // Uma pista morre ao colidir, ao chegar ou ao esgotar o genótipo
+    int vivas = (1 << n) - 1;
+    for (int feito = 0; feito < maior && vivas; feito += INTERVALO_RETOMADA) {
+        int32_t tam_trecho[LARGURA_LOTE], mov_trecho[LARGURA_LOTE], col_trecho[LARGURA_LOTE];
+        for (int pista = 0; pista < LARGURA_LOTE; pista++) {
+            int32_t resto = tam[pista] - feito;
+            tam_trecho[pista] = (vivas >> pista & 1) ? (resto < INTERVALO_RETOMADA ? resto : INTERVALO_RETOMADA) : 0;
+            mov_trecho[pista] = col_trecho[pista] = 0;
+        }
+        int passos_trecho = maior - feito < INTERVALO_RETOMADA ? maior - feito : INTERVALO_RETOMADA;
+        percorrer_lote(matriz, passos + (size_t)feito * LARGURA_LOTE, passos_trecho, tam_trecho, pos,
+                       mov_trecho, col_trecho, repeticoes, avaliador->marcas_lote, rodada);
+
+        for (int pista = 0; pista < n; pista++) {
+            if (!(vivas >> pista & 1)) continue;
+            movimentos[pista] += mov_trecho[pista];
+            colisoes[pista] += col_trecho[pista];
+            if (mov_trecho[pista] < INTERVALO_RETOMADA || pos[pista] == (int32_t)matriz->pos_final) {
+                vivas &= ~(1 << pista);
+                continue;
+            }
+            No *no = nos[pista];
+            if (no->pontos && no->num_pontos < no->capacidade / INTERVALO_RETOMADA) {
+                no->pontos[no->num_pontos].pos = pos[pista];
+                no->pontos[no->num_pontos].repeticoes = repeticoes[pista];
+                no->num_pontos++;
+            }
+        }
+    }
+
+    for (int pista = 0; pista < n; pista++) {
+        No *no = nos[pista];
+        no->x = (int)(pos[pista] / matriz->largura) - 1;
+        no->y = (int)(pos[pista] % matriz->largura) - 1;
+        no->colisoes = colisoes[pista];
+        if (truncar) {
+            // O caminho cortado não contém o movimento que colidiu
+            no->tam_genotipo = movimentos[pista];
+            no->totalMov = movimentos[pista];
+            no->fitness = pontuacao(matriz, pos[pista], 0, repeticoes[pista], no->totalMov);
+        } else {
+            no->fitness = pontuacao(matriz, pos[pista], colisoes[pista], repeticoes[pista], no->totalMov);
+        }
+    }
+}
+
+void avaliar_lote(Avaliador *avaliador, No **individuos, int n) {
+    if (!avaliador || !individuos) return;
+    for (int i = 0; i < n; i += LARGURA_LOTE)
+        avaliar_bloco(avaliador, individuos + i, n - i < LARGURA_LOTE ? n - i : LARGURA_LOTE, 0);
+}
+
+static inline uint64_t misturar_hash(uint64_t h, uint64_t palavra) {
+    h = (h ^ palavra) * 0x9FB21C651E98DF25ull;
+    return h ^ (h >> 28);
+}
+
+/* Resumo de 64 bits do genótipo, usado pelo cache de fitness e para estimar
+ * a diversidade. Consome 8 bytes por passo (uma palavra compacta ou oito
+ * letras); os bits além do fim da última palavra compacta são ignorados. */
+static uint64_t hash_genotipo(const No *no) {
+    const int tam = no->tam_genotipo;
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ (uint64_t)tam;
+    if (no->genes) {
+        int palavras = (tam + 31) / 32;
+        for (int i = 0; i < palavras; i++) {
+            uint64_t palavra = no->genes[i];
+            int resto = tam - i * 32;
+            if (resto < 32) palavra &= ((uint64_t)1 << (2 * resto)) - 1;
+            h = misturar_hash(h, palavra);
+        }
+    } else {
+        int i = 0;
+        for (; i + 8 <= tam; i += 8) {
+            uint64_t palavra;
+            memcpy(&palavra, no->genotipo + i, sizeof(palavra));
+            h = misturar_hash(h, palavra);
+        }
+        if (i < tam) {
+            uint64_t palavra = 0;
+            memcpy(&palavra, no->genotipo + i, (size_t)(tam - i));
+            h = misturar_hash(h, palavra);
+        }
+    }
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    return h ^ (h >> 33);
+}
+
+/* Entradas examinadas a partir da posição da chave antes de desistir. */
+#define SONDAGEM_CACHE 4
+
+/* Copia para `no` o resultado guardado sob `chave`; retorna 0 se não há. */
+static int consultar_cache(CacheFitness *cache, uint64_t chave, No *no) {
+    for (size_t k = 0; k < SONDAGEM_CACHE; k++) {
+        EntradaCache *e = &cache->entradas[(chave + k) & cache->mascara];
+        unsigned v1 = atomic_load_explicit(&e->versao, memory_order_acquire);
+        if (v1 & 1u) continue;
+        uint64_t guardada = atomic_load_explicit(&e->chave, memory_order_relaxed);
+        if (guardada == 0) return 0;
+        if (guardada != chave) continue;
+        uint64_t d0 = atomic_load_explicit(&e->dados[0], memory_order_relaxed);
+        uint64_t d1 = atomic_load_explicit(&e->dados[1], memory_order_relaxed);
+        uint64_t d2 = atomic_load_explicit(&e->dados[2], memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&e->versao, memory_order_relaxed) != v1) return 0;
+        uint32_t bits = (uint32_t)d0;
+        memcpy(&no->fitness, &bits, sizeof(bits));
+        no->tam_genotipo = (int32_t)(uint32_t)(d0 >> 32);
+        no->totalMov = (int32_t)(uint32_t)d1;
+        no->colisoes = (int32_t)(uint32_t)(d1 >> 32);
+        no->x = (int32_t)(uint32_t)d2;
+        no->y = (int32_t)(uint32_t)(d2 >> 32);
+        return 1;
+    }
+    return 0;
+}
+
+/* Guarda o resultado de `no` sob `chave`, numa entrada vazia da sondagem ou,
+ * se todas estiverem ocupadas, no lugar de uma delas. Se outra thread estiver
+ * escrevendo na entrada escolhida, desiste: o cache é só um atalho. */
+static void inserir_cache(CacheFitness *cache, uint64_t chave, const No *no) {
+    EntradaCache *alvo = NULL;
+    for (size_t k = 0; k < SONDAGEM_CACHE; k++) {
+        EntradaCache *e = &cache->entradas[(chave + k) & cache->mascara];
+        uint64_t guardada = atomic_load_explicit(&e->chave, memory_order_relaxed);
+        if (guardada == chave) return;
+        if (guardada == 0) {
+            alvo = e;
+            break;
+        }
+    }
+    if (!alvo) alvo = &cache->entradas[(chave + (chave >> 62)) & cache->mascara];
+
+    unsigned v = atomic_load_explicit(&alvo->versao, memory_order_relaxed);
+    if ((v & 1u) || !atomic_compare_exchange_strong_explicit(&alvo->versao, &v, v + 1,
+                                                            memory_order_relaxed, memory_order_relaxed))
+        return;
+    atomic_thread_fence(memory_order_release);
+    uint32_t bits;
+    memcpy(&bits, &no->fitness, sizeof(bits));
+    atomic_store_explicit(&alvo->chave, chave, memory_order_relaxed);
+    atomic_store_explicit(&alvo->dados[0], bits | (uint64_t)(uint32_t)no->tam_genotipo << 32, memory_order_relaxed);
+    atomic_store_explicit(&alvo->dados[1], (uint32_t)no->totalMov | (uint64_t)(uint32_t)no->colisoes << 32,
+                          memory_order_relaxed);
+    atomic_store_explicit(&alvo->dados[2], (uint32_t)no->x | (uint64_t)(uint32_t)no->y << 32, memory_order_relaxed);
+    atomic_store_explicit(&alvo->versao, v + 2, memory_order_release);
+}
+
+static uint64_t chave_cache(const No *no) {
+    uint64_t chave = hash_genotipo(no);
+    return chave ? chave : 1;
+}
+
+/* Avalia um bloco; filhos já vistos no cache do mapa são copiados de lá, e
+ * só os demais passam pelo percurso. Passeios aleatórios (sem corte) vão
+ * direto: raramente se repetem, e seu fitness depende de totalMov. */
+static void avaliar_com_cache(Avaliador *avaliador, No *const *nos, int n, int truncar) {
+    CacheFitness *cache = avaliador->matriz->cache;
+    if (!cache || !truncar) {
+        avaliar_bloco(avaliador, nos, n, truncar);
+        return;
+    }
+    No *faltam[LARGURA_LOTE];
+    uint64_t chaves[LARGURA_LOTE];
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        uint64_t chave = chave_cache(nos[i]);
+        if (!consultar_cache(cache, chave, nos[i])) {
+            chaves[m] = chave;
+            faltam[m++] = nos[i];
+        }
+    }
+    atomic_fetch_add_explicit(&cache->consultas, (unsigned long long)n, memory_order_relaxed);
+    atomic_fetch_add_explicit(&cache->acertos, (unsigned long long)(n - m), memory_order_relaxed);
+    if (m == 0) return;
+    avaliar_bloco(avaliador, faltam, m, 1);
+    for (int i = 0; i < m; i++)
+        inserir_cache(cache, chaves[i], faltam[i]);
+    atomic_fetch_add_explicit(&cache->insercoes, (unsigned long long)m, memory_order_relaxed);
+}
+
+int ativar_cache_fitness(Matriz *matriz, int entradas) {
+    if (!matriz || entradas < 0) return 0;
+    liberar_cache(matriz->cache);
+    matriz->cache = NULL;
+    if (entradas == 0) return 1;
+
+    size_t capacidade = SONDAGEM_CACHE;
+    while (capacidade < (size_t)entradas) capacidade <<= 1;
+    CacheFitness *cache = calloc(1, sizeof(CacheFitness));
+    if (cache) cache->entradas = calloc(capacidade, sizeof(EntradaCache));
+    if (!cache || !cache->entradas) {
+        free(cache);
+        printf("Erro ao alocar o cache de fitness\n");
+        return 0;
+    }
+    cache->mascara = capacidade - 1;
+    matriz->cache = cache;
+    return 1;
+}
+
+int estatisticas_cache_fitness(const Matriz *matriz, EstatisticasCache *estatisticas) {
+    if (!matriz || !estatisticas || !matriz->cache) return 0;
+    CacheFitness *cache = matriz->cache;
+    estatisticas->capacidade = cache->mascara + 1;
+    estatisticas->consultas = atomic_load_explicit(&cache->consultas, memory_order_relaxed);
+    estatisticas->acertos = atomic_load_explicit(&cache->acertos, memory_order_relaxed);
+    estatisticas->insercoes = atomic_load_explicit(&cache->insercoes, memory_order_relaxed);
+    return 1;
+}
+
+/* Mutação compactada: em vez de sortear um real por gene, sorteia o
+ * intervalo até o próximo gene mutado (distribuição geométrica), o que dá a
+ * mesma probabilidade por gene com um sorteio por mutação. */
+static int mutar_compacto(uint64_t *genes, int n, float taxa_mutacao, Gerador *gerador) {
+    if (taxa_mutacao <= 0.0f) return n;
+    if (taxa_mutacao >= 1.0f) {
+        sortear_genes(genes, 0, n, gerador);
+        return 0;
+    }
+    const float log_q = logf(1.0f - taxa_mutacao);
+    int i = -1, primeiro = n;
+    for (;;) {
+        float salto = logf(1.0f - gerador_real(gerador)) / log_q;
+        if (salto >= (float)(n - i - 1)) break;
+        i += 1 + (int)salto;
+        if (primeiro == n) primeiro = i;
+        definir_gene_compacto(genes, i, gerador_intervalo(gerador, 4));
+    }
+    return primeiro;
+}
+
+/* Muta o genótipo e descarta os pontos de retomada a partir do primeiro
+ * gene sorteado. */
+static void mutar(No *individuo, float taxa_mutacao, Gerador *gerador) {
+    int primeiro = individuo->tam_genotipo;
+    if (individuo->genes) {
+        primeiro = mutar_compacto(individuo->genes, individuo->tam_genotipo, taxa_mutacao, gerador);
+    } else {
+        for (int i = 0; i < individuo->tam_genotipo; i++) {
+            if (gerador_real(gerador) < taxa_mutacao) {
+                individuo->genotipo[i] = direcoes[gerador_intervalo(gerador, 4)];
+                if (i < primeiro) primeiro = i;
+            }
+        }
+    }
+    if (individuo->num_pontos > primeiro / INTERVALO_RETOMADA)
+        individuo->num_pontos = primeiro / INTERVALO_RETOMADA;
+}
+
+void aplicar_mutacao(No *individuo, float taxa_mutacao) {
+    mutar(individuo, taxa_mutacao, &gerador_global);
+}
+
+static int arena_copiar_elite(const Arena *origem, Arena *destino, int n) {
+    if (n > origem->quantidade) n = origem->quantidade;
+    if (!arena_reservar(destino, destino->quantidade + n)) return 0;
+    for (int i = 0; i < n; i++) {
+        copiar_individuo(&origem->individuos[i], arena_novo_individuo(destino));
+    }
+    return 1;
+}
+
+void aplicar_elitismo(Lista *origem, Lista *destino, int n) {
+    if (!origem || !destino) return;
+    arena_copiar_elite(&origem->atual, &destino->atual, n);
+}
+
+/* Converte o fitness em uma chave inteira cuja ordem crescente corresponde
+ * à ordem decrescente de fitness. */
+static inline uint32_t chave_fitness(float fitness) {
+    uint32_t bits;
+    memcpy(&bits, &fitness, sizeof(bits));
+    bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    return ~bits;
+}
+
+static int ranking_reservar(Ranking *ranking, int n) {
+    if (n <= ranking->capacidade) return 1;
+    uint64_t *entradas = malloc((size_t)n * sizeof(uint64_t));
+    uint64_t *auxiliar = malloc((size_t)n * sizeof(uint64_t));
+    No *individuos = malloc((size_t)n * sizeof(No));
+    if (!entradas || !auxiliar || !individuos) {
+        printf("Erro ao alocar buffers de ordenacao\n");
+        free(entradas);
+        free(auxiliar);
+        free(individuos);
+        return 0;
+    }
+    free(ranking->entradas);
+    free(ranking->auxiliar);
+    free(ranking->individuos);
+    ranking->alocacoes += 3;
+    ranking->bytes_alocados += (size_t)n * (2 * sizeof(uint64_t) + sizeof(No));
+    ranking->entradas = entradas;
+    ranking->auxiliar = auxiliar;
+    ranking->individuos = individuos;
+    ranking->capacidade = n;
+    return 1;
+}
+
+static int ranking_reservar_acumulado(Ranking *ranking, int n) {
+    if (n <= ranking->capacidade_acumulado) return 1;
+    double *acumulado = malloc((size_t)n * sizeof(double));
+    if (!acumulado) {
+        printf("Erro ao alocar buffer de selecao\n");
+        return 0;
+    }
+    free(ranking->acumulado);
+    ranking->alocacoes++;
+    ranking->bytes_alocados += (size_t)n * sizeof(double);
+    ranking->acumulado = acumulado;
+    ranking->capacidade_acumulado = n;
+    return 1;
+}
+
+static void ranking_liberar(Ranking *ranking) {
+    free(ranking->entradas);
+    free(ranking->auxiliar);
+    free(ranking->individuos);
+    free(ranking->acumulado);
+    ranking->entradas = ranking->auxiliar = NULL;
+    ranking->individuos = NULL;
+    ranking->acumulado = NULL;
+    ranking->capacidade = ranking->capacidade_acumulado = 0;
+}
+
+/* Radix sort LSD estável sobre os 32 bits altos (a chave); passagens em que
+ * todas as entradas têm o mesmo byte são puladas. */
+static uint64_t *radix_entradas(uint64_t *entradas, uint64_t *auxiliar, int n) {
+    for (int byte = 4; byte < 8; byte++) {
+        const int deslocamento = byte * 8;
+        int contagem[256] = {0};
+        for (int i = 0; i < n; i++)
+            contagem[(entradas[i] >> deslocamento) & 0xFF]++;
+        if (contagem[(entradas[0] >> deslocamento) & 0xFF] == n) continue;
+
+        int soma = 0;
+        for (int d = 0; d < 256; d++) {
+            int c = contagem[d];
+            contagem[d] = soma;
+            soma += c;
+        }
+        for (int i = 0; i < n; i++)
+            auxiliar[contagem[(entradas[i] >> deslocamento) & 0xFF]++] = entradas[i];
+
+        uint64_t *troca = entradas;
+        entradas = auxiliar;
+        auxiliar = troca;
+    }
+    return entradas;
+}
+
+static void heap_descer(uint64_t *heap, int n, int i) {
+    for (;;) {
+        int maior = i, esq = 2 * i + 1, dir = 2 * i + 2;
+        if (esq < n && heap[esq] > heap[maior]) maior = esq;
+        if (dir < n && heap[dir] > heap[maior]) maior = dir;
+        if (maior == i) return;
+        uint64_t aux = heap[i];
+        heap[i] = heap[maior];
+        heap[maior] = aux;
+        i = maior;
+    }
+}
+
+/* Seleciona as k menores entradas com um heap de máximo de tamanho k e as
+ * devolve ordenadas em heap[0..k). O(n log k). */
+static void selecionar_menores(const uint64_t *entradas, int n, uint64_t *heap, int k) {
+    for (int i = 0; i < k; i++)
+        heap[i] = entradas[i];
+    for (int i = k / 2 - 1; i >= 0; i--)
+        heap_descer(heap, k, i);
+    for (int i = k; i < n; i++) {
+        if (entradas[i] < heap[0]) {
+            heap[0] = entradas[i];
+            heap_descer(heap, k, 0);
+        }
+    }
+    for (int fim = k - 1; fim > 0; fim--) {
+        uint64_t aux = heap[0];
+        heap[0] = heap[fim];
+        heap[fim] = aux;
+        heap_descer(heap, fim, 0);
+    }
+}
+
+void ordenar_parcial_por_fitness(Lista *lista, int k) {
+    if (lista == NULL || lista->atual.quantidade == 0) return;
+
+    Arena *arena = &lista->atual;
+    Ranking *ranking = &lista->ranking;
+    const int n = arena->quantidade;
+    if (k <= 0) return;
+    if (k > n) k = n;
+    if (!ranking_reservar(ranking, n)) return;
+
+    // Empates são desfeitos pelo índice original, como numa ordenação estável
+    uint64_t *entradas = ranking->entradas;
+    for (int i = 0; i < n; i++)
+        entradas[i] = ((uint64_t)chave_fitness(arena->individuos[i].fitness) << 32) | (uint32_t)i;
+
+    No *ordenados = ranking->individuos;
+    int pos = 0;
+    if (k < n / 4) {
+        uint64_t *melhores = ranking->auxiliar;
+        selecionar_menores(entradas, n, melhores, k);
+        for (int i = 0; i < k; i++)
+            ordenados[pos++] = arena->individuos[(uint32_t)melhores[i]];
+        // Os demais seguem na ordem original, depois dos k melhores
+        const uint64_t limite = melhores[k - 1];
+        for (int i = 0; i < n; i++)
+            if (entradas[i] > limite)
+                ordenados[pos++] = arena->individuos[i];
+    } else {
+        uint64_t *resultado = radix_entradas(entradas, ranking->auxiliar, n);
+        for (int i = 0; i < n; i++)
+            ordenados[pos++] = arena->individuos[(uint32_t)resultado[i]];
+    }
+
+    memcpy(arena->individuos, ordenados, (size_t)n * sizeof(No));
+    arena_religar(arena);
+}
+
+void ordenar_por_fitness(Lista *lista) {
+    if (lista == NULL) return;
+    ordenar_parcial_por_fitness(lista, lista->atual.quantidade);
+}
+
+static unsigned long long agora_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (unsigned long long)t.tv_sec * 1000000000ull + (unsigned long long)t.tv_nsec;
+}
+
+/* Soma à etapa o tempo decorrido desde `*t` e reinicia a contagem. */
+static inline void marcar_etapa(unsigned long long *tempos, int etapa, unsigned long long *t) {
+    unsigned long long agora = agora_ns();
+    tempos[etapa] += agora - *t;
+    *t = agora;
+}
+
+/* Medição de uma geração em andamento; `tempos` é NULL com a telemetria
+ * desligada e, ligada, guarda um acumulador por thread. */
+typedef struct _medicao {
+    unsigned long long (*tempos)[TELEMETRIA_TOTAL_ETAPAS];
+    int num_tempos;
+    unsigned long long inicio;
+    unsigned long long alocacoes;
+    unsigned long long bytes_alocados;
+    unsigned long long consultas_cache;
+    unsigned long long acertos_cache;
+} Medicao;
+
+static void contar_alocacoes(const Lista *lista, unsigned long long *alocacoes, unsigned long long *bytes) {
+    *alocacoes = lista->atual.alocacoes + lista->reserva.alocacoes + lista->ranking.alocacoes;
+    *bytes = lista->atual.bytes_alocados + lista->reserva.bytes_alocados + lista->ranking.bytes_alocados;
+}
+
+static void iniciar_medicao(const Lista *lista, const Matriz *matriz,
+                            unsigned long long (*tempos)[TELEMETRIA_TOTAL_ETAPAS], int num_tempos,
+                            Medicao *medicao) {
+    medicao->tempos = NULL;
+    if (!lista->telemetria.sink) return;
+    medicao->tempos = tempos;
+    medicao->num_tempos = num_tempos;
+    memset(tempos, 0, (size_t)num_tempos * sizeof(*tempos));
+    contar_alocacoes(lista, &medicao->alocacoes, &medicao->bytes_alocados);
+    EstatisticasCache cache = {0};
+    estatisticas_cache_fitness(matriz, &cache);
+    medicao->consultas_cache = cache.consultas;
+    medicao->acertos_cache = cache.acertos;
+    medicao->inicio = agora_ns();
+}
+
+static void medir_ordenacao(Medicao *medicao) {
+    if (medicao->tempos)
+        medicao->tempos[0][TELEMETRIA_ORDENACAO] = agora_ns() - medicao->inicio;
+}
+
+static int comparar_hash(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Fecha a medição: soma os acumuladores das threads, calcula as
+ * estatísticas da nova geração e as entrega ao sink. */
+static void concluir_medicao(Lista *lista, const Matriz *matriz, const Medicao *medicao) {
+    if (!medicao->tempos) return;
+    EstatisticasGeracao e;
+    memset(&e, 0, sizeof(e));
+    e.ns_total = agora_ns() - medicao->inicio;
+    for (int i = 0; i < medicao->num_tempos; i++)
+        for (int etapa = 0; etapa < TELEMETRIA_TOTAL_ETAPAS; etapa++)
+            e.ns[etapa] += medicao->tempos[i][etapa];
+    contar_alocacoes(lista, &e.alocacoes, &e.bytes_alocados);
+    e.alocacoes -= medicao->alocacoes;
+    e.bytes_alocados -= medicao->bytes_alocados;
+    EstatisticasCache cache = {0};
+    if (estatisticas_cache_fitness(matriz, &cache) && cache.consultas > medicao->consultas_cache)
+        e.taxa_cache = (float)(cache.acertos - medicao->acertos_cache)
+                       / (float)(cache.consultas - medicao->consultas_cache);
+
+    const Arena *arena = &lista->atual;
+    e.geracao = ++lista->telemetria.geracao;
+    e.populacao = arena->quantidade;
+    if (arena->quantidade > 0) {
+        double soma = 0.0;
+        int no_objetivo = 0;
+        e.melhor_fitness = e.pior_fitness = arena->individuos[0].fitness;
+        for (int i = 0; i < arena->quantidade; i++) {
+            const No *no = &arena->individuos[i];
+            soma += no->fitness;
+            if (no->fitness > e.melhor_fitness) e.melhor_fitness = no->fitness;
+            if (no->fitness < e.pior_fitness) e.pior_fitness = no->fitness;
+            if (no->x == matriz->x_final && no->y == matriz->y_final) no_objetivo++;
+        }
+        e.media_fitness = (float)(soma / arena->quantidade);
+        e.taxa_objetivo = (float)no_objetivo / (float)arena->quantidade;
+
+        // Os buffers de ordenação ficam livres até a próxima geração
+        if (ranking_reservar(&lista->ranking, arena->quantidade)) {
+            uint64_t *hashes = lista->ranking.entradas;
+            for (int i = 0; i < arena->quantidade; i++)
+                hashes[i] = hash_genotipo(&arena->individuos[i]);
+            qsort(hashes, (size_t)arena->quantidade, sizeof(uint64_t), comparar_hash);
+            int distintos = 1;
+            for (int i = 1; i < arena->quantidade; i++)
+                distintos += hashes[i] != hashes[i - 1];
+            e.diversidade = (float)distintos / (float)arena->quantidade;
+        }
+    }
+    lista->telemetria.sink(&e, lista->telemetria.contexto);
+}
+
+void definir_telemetria(Lista *lista, SinkTelemetria sink, void *contexto) {
+    if (!lista) return;
+    lista->telemetria.sink = sink;
+    lista->telemetria.contexto = contexto;
+}
+
+static const char *nomes_etapas_telemetria[TELEMETRIA_TOTAL_ETAPAS] = {
+    "ordenacao", "elitismo", "crossover", "mutacao", "avaliacao", "reposicao"
+};
+
+const char *nome_etapa_telemetria(EtapaTelemetria etapa) {
+    if ((int)etapa < 0 || etapa >= TELEMETRIA_TOTAL_ETAPAS) return "";
+    return nomes_etapas_telemetria[etapa];
+}
+
+void escrever_cabecalho_telemetria_csv(FILE *arquivo) {
+    fprintf(arquivo, "geracao");
+    for (int etapa = 0; etapa < TELEMETRIA_TOTAL_ETAPAS; etapa++)
+        fprintf(arquivo, ",%s_ns", nomes_etapas_telemetria[etapa]);
+    fprintf(arquivo, ",total_ns,alocacoes,bytes_alocados,populacao,melhor_fitness,"
+                     "media_fitness,pior_fitness,diversidade,taxa_objetivo,taxa_cache\n");
+}
+
+void escrever_telemetria_csv(const EstatisticasGeracao *e, void *arquivo) {
+    FILE *saida = arquivo;
+    fprintf(saida, "%d", e->geracao);
+    for (int etapa = 0; etapa < TELEMETRIA_TOTAL_ETAPAS; etapa++)
+        fprintf(saida, ",%llu", e->ns[etapa]);
+    fprintf(saida, ",%llu,%llu,%llu,%d,%.2f,%.2f,%.2f,%.4f,%.4f,%.4f\n", e->ns_total, e->alocacoes,
+            e->bytes_alocados, e->populacao, e->melhor_fitness, e->media_fitness, e->pior_fitness,
+            e->diversidade, e->taxa_objetivo, e->taxa_cache);
+}
+
+void escrever_telemetria_json(const EstatisticasGeracao *e, void *arquivo) {
+    FILE *saida = arquivo;
+    fprintf(saida, "{\"geracao\": %d, \"etapas_ns\": {", e->geracao);
+    for (int etapa = 0; etapa < TELEMETRIA_TOTAL_ETAPAS; etapa++)
+        fprintf(saida, "%s\"%s\": %llu", etapa ? ", " : "", nomes_etapas_telemetria[etapa], e->ns[etapa]);
+    fprintf(saida, "}, \"total_ns\": %llu, \"alocacoes\": %llu, \"bytes_alocados\": %llu, "
+                   "\"populacao\": %d, \"melhor_fitness\": %.2f, \"media_fitness\": %.2f, "
+                   "\"pior_fitness\": %.2f, \"diversidade\": %.4f, \"taxa_objetivo\": %.4f, "
+                   "\"taxa_cache\": %.4f}\n",
+            e->ns_total, e->alocacoes, e->bytes_alocados, e->populacao, e->melhor_fitness,
+            e->media_fitness, e->pior_fitness, e->diversidade, e->taxa_objetivo, e->taxa_cache);
+}
+
+/* Descrição de uma geração em construção: os `elite` primeiros espaços do
+ * destino já foram copiados; os espaços [primeiro, total) são preenchidos
+ * por construir_individuos(), os `filhos` primeiros por crossover. Na
+ * amostragem universal, o ponteiro j está em inicio + j * passo sobre
+ * `acumulado`. */
+typedef struct _construcao {
+    const Arena *origem;
+    Arena *destino;
+    Matriz *matriz;
+    PoolThreads *pool;
+    const Configuracao *config;
+    unsigned long long (*tempos)[TELEMETRIA_TOTAL_ETAPAS]; /* NULL sem telemetria */
+    int primeiro;
+    int total;
+    int filhos;
+    int avaliacao_remota;  /* só constrói; quem chamou envia para avaliar */
+    const double *acumulado;
+    double inicio;
+    double passo;
+} Construcao;
+
+/* Ordem da seleção: maior fitness e, no empate, menor índice, como na
+ * ordenação estável. */
+static inline int melhor_que(const No *individuos, int a, int b) {
+    return individuos[a].fitness > individuos[b].fitness ||
+           (individuos[a].fitness == individuos[b].fitness && a < b);
+}
+
+static int selecionar_torneio(const Arena *origem, int k, Gerador *gerador) {
+    int melhor = gerador_intervalo(gerador, origem->quantidade);
+    for (int i = 1; i < k; i++) {
+        int candidato = gerador_intervalo(gerador, origem->quantidade);
+        if (melhor_que(origem->individuos, candidato, melhor)) melhor = candidato;
+    }
+    return melhor;
+}
+
+/* Torneio binário em que o melhor vence com probabilidade s/2: a chance do
+ * indivíduo de posição r (0 = melhor) é (s(n-1) - 2r(s-1) + 1)/n², linear
+ * em r, ou seja, a roleta por ranking linear com pressão s, sem ordenar. */
+static int selecionar_ranking(const Arena *origem, float pressao, Gerador *gerador) {
+    int a = gerador_intervalo(gerador, origem->quantidade);
+    int b = gerador_intervalo(gerador, origem->quantidade);
+    if (melhor_que(origem->individuos, b, a)) {
+        int aux = a;
+        a = b;
+        b = aux;
+    }
+    return gerador_real(gerador) < pressao * 0.5f ? a : b;
+}
+
+/* Primeiro índice cuja soma acumulada passa do ponteiro; O(log n). */
+static int selecionar_amostragem(const Construcao *c, int j) {
+    double ponteiro = c->inicio + j * c->passo;
+    int esq = 0, dir = c->origem->quantidade - 1;
+    while (esq < dir) {
+        int meio = esq + (dir - esq) / 2;
+        if (c->acumulado[meio] > ponteiro) dir = meio;
+        else esq = meio + 1;
+    }
+    return esq;
+}
+
+/* Escolhe os pais do k-ésimo filho. Na amostragem universal, os 2*filhos
+ * ponteiros caem em ordem de índice; o filho k junta os ponteiros k e
+ * k + filhos para não cruzar vizinhos de posição. */
+static void selecionar_pais(const Construcao *c, int k, Gerador *gerador, const No **pai1, const No **pai2) {
+    const Arena *origem = c->origem;
+    int a, b;
+    switch (c->config->selecao) {
+    case SELECAO_TORNEIO:
+        a = selecionar_torneio(origem, c->config->tamanho_torneio, gerador);
+        b = selecionar_torneio(origem, c->config->tamanho_torneio, gerador);
+        break;
+    case SELECAO_AMOSTRAGEM:
+        a = selecionar_amostragem(c, k);
+        b = selecionar_amostragem(c, k + c->filhos);
+        break;
+    case SELECAO_RANKING:
+        a = selecionar_ranking(origem, c->config->pressao_ranking, gerador);
+        b = selecionar_ranking(origem, c->config->pressao_ranking, gerador);
+        break;
+    default:
+        a = 2 * k;
+        b = 2 * k + 1;
+        break;
+    }
+    *pai1 = &origem->individuos[a];
+    *pai2 = &origem->individuos[b];
+}
+
+/* Prepara a amostragem universal: pesos proporcionais ao fitness acima do
+ * pior (iguais se todos empatam) e um único sorteio para o primeiro
+ * ponteiro; os demais ficam a intervalos fixos. O(n). */
+static int preparar_amostragem(Ranking *ranking, Construcao *c, Gerador *gerador) {
+    const Arena *origem = c->origem;
+    const int n = origem->quantidade;
+    if (!ranking_reservar_acumulado(ranking, n)) return 0;
+
+    float pior = origem->individuos[0].fitness;
+    for (int i = 1; i < n; i++)
+        if (origem->individuos[i].fitness < pior) pior = origem->individuos[i].fitness;
+    double soma = 0.0;
+    for (int i = 0; i < n; i++) {
+        soma += (double)origem->individuos[i].fitness - pior;
+        ranking->acumulado[i] = soma;
+    }
+    if (!(soma > 0.0) || !isfinite(soma)) {
+        for (int i = 0; i < n; i++) ranking->acumulado[i] = i + 1;
+        soma = n;
+    }
+    c->acumulado = ranking->acumulado;
+    c->passo = c->filhos > 0 ? soma / (2.0 * c->filhos) : 0.0;
+    c->inicio = gerador_real(gerador) * c->passo;
+    return 1;
+}
+
+/* Copia `n` movimentos de `origem`, a partir de `de`, para `destino` a
+ * partir de `para`; os dois nós usam a mesma codificação. */
+static void copiar_trecho(No *destino, int para, const No *origem, int de, int n) {
+    if (n <= 0) return;
+    if (destino->genes)
+        copiar_genes(destino->genes, para, origem->genes, de, n);
+    else
+        memcpy(destino->genotipo + para, origem->genotipo + de, (size_t)n);
+}
+
+/* Sorteia os movimentos [para, para + n) de `destino`. */
+static void sortear_trecho(No *destino, int para, int n, Gerador *gerador) {
+    if (destino->genes) {
+        sortear_genes(destino->genes, para, n, gerador);
+    } else {
+        for (int i = para; i < para + n; i++)
+            destino->genotipo[i] = direcoes[gerador_intervalo(gerador, 4)];
+    }
+}
+
+/* Acrescenta ao filho, que já tem `tam` movimentos, até `n` movimentos de
+ * `origem` a partir de `de`, sem passar da capacidade. */
+static int acrescentar_trecho(No *filho, int tam, const No *origem, int de, int n) {
+    if (n > filho->capacidade - tam) n = filho->capacidade - tam;
+    copiar_trecho(filho, tam, origem, de, n);
+    return tam + (n > 0 ? n : 0);
+}
+
+/* Início do primeiro pai, fim do segundo, com tam_filho movimentos: as
+ * metades que faltam aos pais curtos são sorteadas. */
+static int cruzar_metades(const No *atual, const No *proximo, No *filho,
+                          const Configuracao *config, Gerador *gerador) {
+    int metade = config->tam_filho / 2;
+    int resto = config->tam_filho - metade;
+    filho->tam_genotipo = config->tam_filho;
+
+    int tam1 = atual->tam_genotipo < metade ? atual->tam_genotipo : metade;
+    int tam2 = proximo->tam_genotipo;
+    int inicio2 = tam2 > resto ? tam2 - resto : 0;
+    int tam2_real = tam2 - inicio2;
+
+    if (filho->genes) {
+        copiar_genes(filho->genes, 0, atual->genes, 0, tam1);
+        sortear_genes(filho->genes, tam1, metade - tam1, gerador);
+        copiar_genes(filho->genes, metade, proximo->genes, inicio2, tam2_real);
+        sortear_genes(filho->genes, metade + tam2_real, resto - tam2_real, gerador);
+    } else {
+        for (int i = 0; i < metade; i++) {
+            filho->genotipo[i] = (i < tam1) ? atual->genotipo[i] : direcoes[gerador_intervalo(gerador, 4)];
+        }
+
+        for (int i = 0; i < resto; i++) {
+            int idx = inicio2 + i;
+            filho->genotipo[metade + i] = (i < tam2_real) ? proximo->genotipo[idx] : direcoes[gerador_intervalo(gerador, 4)];
+        }
+    }
+    return tam1;
+}
+
+/* atual[0, a) + proximo[b, fim), com cortes independentes nos dois pais. */
+static int cruzar_um_ponto(const No *atual, const No *proximo, No *filho, Gerador *gerador) {
+    int a = gerador_intervalo(gerador, atual->tam_genotipo + 1);
+    int b = gerador_intervalo(gerador, proximo->tam_genotipo + 1);
+    int tam = acrescentar_trecho(filho, 0, atual, 0, a);
+    filho->tam_genotipo = acrescentar_trecho(filho, tam, proximo, b, proximo->tam_genotipo - b);
+    return a;
+}
+
+static void sortear_cortes(int tam, Gerador *gerador, int *de, int *ate) {
+    int a = gerador_intervalo(gerador, tam + 1);
+    int b = gerador_intervalo(gerador, tam + 1);
+    *de = a < b ? a : b;
+    *ate = a < b ? b : a;
+}
+
+/* atual[0, a) + proximo[c, d) + atual[b, fim): o trecho [a, b) do primeiro
+ * pai é trocado pelo trecho [c, d) do segundo. */
+static int cruzar_dois_pontos(const No *atual, const No *proximo, No *filho, Gerador *gerador) {
+    int a, b, c, d;
+    sortear_cortes(atual->tam_genotipo, gerador, &a, &b);
+    sortear_cortes(proximo->tam_genotipo, gerador, &c, &d);
+    int tam = acrescentar_trecho(filho, 0, atual, 0, a);
+    tam = acrescentar_trecho(filho, tam, proximo, c, d - c);
+    filho->tam_genotipo = acrescentar_trecho(filho, tam, atual, b, atual->tam_genotipo - b);
+    return a;
+}
+
+static int preparar_cruzamento(Avaliador *avaliador) {
+    if (!avaliador->indices_cruzamento) {
+        avaliador->indices_cruzamento = malloc(avaliador->matriz->total_celulas * sizeof(int32_t));
+        if (!avaliador->indices_cruzamento) {
+            printf("Erro ao alocar indices do cruzamento\n");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static inline int codigo_gene(const No *no, int i) {
+    return no->genes ? 1 + gene_compacto(no->genes, i) : codigo_letra[(unsigned char)no->genotipo[i]];
+}
+
+/* Movimentos sorteados ao fim do filho do cruzamento posicional. */
+#define EXTENSAO_POSICIONAL 10
+
+/* Une os pais numa célula que os dois caminhos visitam: carimba as células
+ * de `atual` com o índice da primeira visita, percorre `proximo` e sorteia,
+ * entre as células em comum, o ponto (i, j) em que o filho deixa atual[0, i)
+ * e segue proximo[j, fim). Como os dois trechos partem da mesma célula, o
+ * filho herda caminhos já válidos em vez de emendá-los às cegas. Um filho
+ * assim só termina em células que os pais já visitaram, por isso ganha
+ * EXTENSAO_POSICIONAL movimentos sorteados no fim. Sem memória para os
+ * índices, recai no corte de um ponto. */
+static int cruzar_posicional(const No *atual, const No *proximo, No *filho,
+                             Avaliador *avaliador, Gerador *gerador) {
+    if (!avaliador || !preparar_cruzamento(avaliador))
+        return cruzar_um_ponto(atual, proximo, filho, gerador);
+
+    const Matriz *matriz = avaliador->matriz;
+    unsigned int *marcas = avaliador->marcas;
+    int32_t *indices = avaliador->indices_cruzamento;
+    if (++avaliador->rodada == 0) {
+        memset(marcas, 0, matriz->total_celulas * sizeof(unsigned int));
+        avaliador->rodada = 1;
+    }
+    const unsigned int rodada = avaliador->rodada;
+
+    ptrdiff_t passo[5];
+    passo[0] = 0;
+    passos_direcao(matriz, passo + 1);
+
+    ptrdiff_t pos = matriz->pos_inicial;
+    marcas[pos] = rodada;
+    indices[pos] = 0;
+    for (int i = 0; i < atual->tam_genotipo; i++) {
+        pos += passo[codigo_gene(atual, i)];
+        if (!celula_livre(matriz, pos)) break;
+        if (marcas[pos] != rodada) {
+            marcas[pos] = rodada;
+            indices[pos] = i + 1;
+        }
+    }
+
+    // Amostragem de reservatório entre as células em comum
+    int corte1 = 0, corte2 = 0, candidatos = 0;
+    pos = matriz->pos_inicial;
+    for (int j = 0;; j++) {
+        if (marcas[pos] == rodada && gerador_intervalo(gerador, ++candidatos) == 0) {
+            corte1 = indices[pos];
+            corte2 = j;
+        }
+        if (j == proximo->tam_genotipo) break;
+        pos += passo[codigo_gene(proximo, j)];
+        if (!celula_livre(matriz, pos)) break;
+    }
+
+    int tam = acrescentar_trecho(filho, 0, atual, 0, corte1);
+    tam = acrescentar_trecho(filho, tam, proximo, corte2, proximo->tam_genotipo - corte2);
+    int extensao = filho->capacidade - tam < EXTENSAO_POSICIONAL ? filho->capacidade - tam : EXTENSAO_POSICIONAL;
+    sortear_trecho(filho, tam, extensao, gerador);
+    filho->tam_genotipo = tam + extensao;
+    return corte1;
+}
+
+/* Monta o genótipo do filho pelo operador de config->crossover. A mutação
+ * é aplicada em seguida por construir_individuos(), e a decodificação e a
+ * avaliação ficam a cargo de avaliar_bloco(); `avaliador` só empresta os
+ * buffers do cruzamento posicional. */
+static void gerar_filho(const No *atual, const No *proximo, No *filho, const Configuracao *config,
+                        Gerador *gerador, Avaliador *avaliador) {
+    // Pais e filho pertencem à mesma lista e, portanto, à mesma codificação
+    int prefixo;
+    switch (config->crossover) {
+    case CROSSOVER_UM_PONTO:
+        prefixo = cruzar_um_ponto(atual, proximo, filho, gerador);
+        break;
+    case CROSSOVER_DOIS_PONTOS:
+        prefixo = cruzar_dois_pontos(atual, proximo, filho, gerador);
+        break;
+    case CROSSOVER_POSICIONAL:
+        prefixo = cruzar_posicional(atual, proximo, filho, avaliador, gerador);
+        break;
+    default:
+        prefixo = cruzar_metades(atual, proximo, filho, config, gerador);
+        break;
+    }
+    filho->totalMov = filho->tam_genotipo;
+    filho->colisoes = 0;
+
+    // O prefixo herdado de `atual` traz consigo os pontos de retomada dele
+    filho->num_pontos = 0;
+    if (filho->pontos && atual->pontos) {
+        int k = atual->num_pontos;
+        if (k > prefixo / INTERVALO_RETOMADA) k = prefixo / INTERVALO_RETOMADA;
+        if (k > filho->capacidade / INTERVALO_RETOMADA) k = filho->capacidade / INTERVALO_RETOMADA;
+        memcpy(filho->pontos, atual->pontos, (size_t)k * sizeof(PontoRetomada));
+        filho->num_pontos = k;
+    }
+}
+
+/* Avalia o bloco pendente e o esvazia; sem avaliador (avaliação remota), os
+ * indivíduos ficam para quem chamou avaliar. */
+static void fechar_bloco(Avaliador *avaliador, No *const *bloco, int *n, int filhos,
+                         unsigned long long *tempos, unsigned long long *t) {
+    if (*n == 0) return;
+    if (avaliador) {
+        avaliar_com_cache(avaliador, bloco, *n, filhos);
+        if (tempos) marcar_etapa(tempos, TELEMETRIA_AVALIACAO, t);
+    }
+    *n = 0;
+}
+
+/* Constrói os espaços [inicio, fim) e os avalia em blocos de LARGURA_LOTE;
+ * filhos (que precisam ser cortados) e passeios aleatórios vão em blocos
+ * separados. Com c->avaliacao_remota os indivíduos são apenas construídos. */
+static void construir_individuos(const Construcao *c, int inicio, int fim, Gerador *gerador,
+                                 Avaliador *avaliador, unsigned long long *tempos) {
+    Avaliador *avaliar = c->avaliacao_remota ? NULL : avaliador;
+    No *bloco[LARGURA_LOTE];
+    int n = 0, bloco_de_filhos = 0;
+    unsigned long long t = tempos ? agora_ns() : 0;
+    for (int j = inicio; j < fim; j++) {
+        No *no = &c->destino->individuos[j];
+        int k = j - c->primeiro;
+        int filho = k < c->filhos;
+        if (filho != bloco_de_filhos)
+            fechar_bloco(avaliar, bloco, &n, bloco_de_filhos, tempos, &t);
+        if (filho) {
+            const No *pai1, *pai2;
+            selecionar_pais(c, k, gerador, &pai1, &pai2);
+            gerar_filho(pai1, pai2, no, c->config, gerador, avaliador);
+            if (tempos) marcar_etapa(tempos, TELEMETRIA_CROSSOVER, &t);
+            mutar(no, c->config->taxa_mutacao, gerador);
+            if (tempos) marcar_etapa(tempos, TELEMETRIA_MUTACAO, &t);
+        } else {
+            passeio_aleatorio(c->matriz, no, c->config->passeio_min, c->config->passeio_max, gerador);
+            if (tempos) marcar_etapa(tempos, TELEMETRIA_REPOSICAO, &t);
+        }
+        bloco[n++] = no;
+        bloco_de_filhos = filho;
+        if (n == LARGURA_LOTE)
+            fechar_bloco(avaliar, bloco, &n, bloco_de_filhos, tempos, &t);
+    }
+    fechar_bloco(avaliar, bloco, &n, bloco_de_filhos, tempos, &t);
+}
+
+/* Parte serial da construção: reserva os espaços do destino, copia a elite
+ * e prepara a seleção. Com pares vizinhos cada pai serve a um só filho;
+ * os demais operadores repetem pais e geram até max_filhos. */
+static int preparar_geracao(const Arena *origem, Arena *destino, Ranking *ranking, Matriz *matriz,
+                            const Configuracao *config, Gerador *gerador,
+                            unsigned long long (*tempos)[TELEMETRIA_TOTAL_ETAPAS], Construcao *c) {
+    if (origem->quantidade == 0) return 0;
+
+    destino->quantidade = 0;
+    if (!arena_reservar(destino, config->tamanho_populacao)) return 0;
+
+    unsigned long long t = tempos ? agora_ns() : 0;
+    arena_copiar_elite(origem, destino, config->elite);
+    if (tempos) marcar_etapa(tempos[0], TELEMETRIA_ELITISMO, &t);
+
+    c->origem = origem;
+    c->destino = destino;
+    c->matriz = matriz;
+    c->pool = NULL;
+    c->config = config;
+    c->tempos = tempos;
+    c->primeiro = destino->quantidade;
+    c->total = config->tamanho_populacao;
+    c->filhos = config->max_filhos;
+    c->avaliacao_remota = 0;
+    if (config->selecao == SELECAO_VIZINHOS && origem->quantidade / 2 < c->filhos)
+        c->filhos = origem->quantidade / 2;
+    if (c->filhos > c->total - c->primeiro) c->filhos = c->total - c->primeiro;
+    c->acumulado = NULL;
+    c->inicio = c->passo = 0.0;
+    if (config->selecao == SELECAO_AMOSTRAGEM) {
+        if (!preparar_amostragem(ranking, c, gerador)) return 0;
+        if (tempos) marcar_etapa(tempos[0], TELEMETRIA_CROSSOVER, &t);
+    }
+
+    while (destino->quantidade < c->total)
+        arena_novo_individuo(destino);
+    return 1;
+}
+
+static int construir_geracao(const Arena *origem, Arena *destino, Ranking *ranking, Matriz *matriz,
+                             const Configuracao *config, Gerador *gerador, Avaliador *avaliador,
+                             unsigned long long (*tempos)[TELEMETRIA_TOTAL_ETAPAS]) {
+    Construcao c;
+    if (!preparar_geracao(origem, destino, ranking, matriz, config, gerador, tempos, &c)) return 0;
+    construir_individuos(&c, c.primeiro, c.total, gerador, avaliador, tempos ? tempos[0] : NULL);
+    return 1;
+}
+
+/* Quantos dos melhores precisam estar ordenados: a elite e, com pares
+ * vizinhos, os pais; os outros operadores de seleção não dependem da ordem. */
+static int melhores_necessarios(const Configuracao *config) {
+    if (config->selecao != SELECAO_VIZINHOS) return config->elite;
+    int pais = 2 * config->max_filhos;
+    return config->elite > pais ? config->elite : pais;
+}
+
+static void trocar_arenas(Lista *lista) {
+    Arena aux = lista->atual;
+    lista->atual = lista->reserva;
+    lista->reserva = aux;
+}
+
+Lista* criar_lista_com_crossover(Lista* lista, Matriz* matriz) {
+    if (lista == NULL || lista->atual.quantidade == 0 || matriz == NULL) return NULL;
+
+    Lista* nova_lista = cria_lista_configurada(&lista->config);
+    if (nova_lista == NULL) return NULL;
+
+    Avaliador *avaliador = avaliador_da_matriz(matriz);
+    if (!avaliador || !construir_geracao(&lista->atual, &nova_lista->atual, &lista->ranking, matriz,
+                                         &nova_lista->config, &gerador_global, avaliador, NULL)) {
+        liberar_lista(nova_lista);
+        return NULL;
+    }
+    return nova_lista;
+}
+
+static void *executar_trabalhador(void *arg) {
+    Trabalhador *trabalhador = arg;
+    PoolThreads *pool = trabalhador->pool;
+    unsigned long vista = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (pool->rodada == vista && !pool->encerrar)
+            pthread_cond_wait(&pool->cond_tarefa, &pool->mutex);
+        if (pool->encerrar) break;
+        vista = pool->rodada;
+        void (*tarefa)(void *, int) = pool->tarefa;
+        void *contexto = pool->contexto;
+        pthread_mutex_unlock(&pool->mutex);
+
+        tarefa(contexto, trabalhador->indice);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->pendentes == 0)
+            pthread_cond_signal(&pool->cond_fim);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+/* Executa tarefa(contexto, i) para cada thread i do pool; a thread chamadora
+ * assume o índice 0 e a função só retorna quando todas terminarem. */
+static void pool_executar(PoolThreads *pool, void (*tarefa)(void *, int), void *contexto) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->tarefa = tarefa;
+    pool->contexto = contexto;
+    pool->pendentes = pool->num_threads - 1;
+    pool->rodada++;
+    pthread_cond_broadcast(&pool->cond_tarefa);
+    pthread_mutex_unlock(&pool->mutex);
+
+    tarefa(contexto, 0);
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->pendentes > 0)
+        pthread_cond_wait(&pool->cond_fim, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+PoolThreads *cria_pool_threads(Matriz *matriz, int num_threads, unsigned long long semente) {
+    if (!matriz || num_threads < 1) return NULL;
+    PoolThreads *pool = calloc(1, sizeof(PoolThreads));
+    if (!pool) return NULL;
+
+    pool->matriz = matriz;
+    pool->num_threads = num_threads;
+    pool->threads_ativas = 1;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond_tarefa, NULL);
+    pthread_cond_init(&pool->cond_fim, NULL);
+    pool->geradores = malloc(num_threads * sizeof(Gerador));
+    pool->avaliadores = calloc(num_threads, sizeof(Avaliador *));
+    pool->threads = malloc(num_threads * sizeof(pthread_t));
+    pool->trabalhadores = malloc(num_threads * sizeof(Trabalhador));
+    pool->tempos = calloc(num_threads, sizeof(*pool->tempos));
+    if (!pool->geradores || !pool->avaliadores || !pool->threads || !pool->trabalhadores || !pool->tempos) {
+        printf("Erro ao alocar pool de threads\n");
+        liberar_pool_threads(pool);
+        return NULL;
+    }
+
+    // Cada thread recebe uma sequência própria derivada da semente
+    uint64_t estado = semente;
+    for (int i = 0; i < num_threads; i++) {
+        gerador_semear(&pool->geradores[i], splitmix64(&estado));
+        pool->avaliadores[i] = cria_avaliador(matriz);
+        if (!pool->avaliadores[i]) {
+            liberar_pool_threads(pool);
+            return NULL;
+        }
+    }
+
+    // A thread chamadora faz o papel do trabalhador 0
+    for (int i = 1; i < num_threads; i++) {
+        pool->trabalhadores[i].pool = pool;
+        pool->trabalhadores[i].indice = i;
+        if (pthread_create(&pool->threads[i], NULL, executar_trabalhador, &pool->trabalhadores[i]) != 0) {
+            printf("Erro ao criar thread %d\n", i);
+            liberar_pool_threads(pool);
+            return NULL;
+        }
+        pool->threads_ativas++;
+    }
+    return pool;
+}
+
+void liberar_pool_threads(PoolThreads *pool) {
+    if (!pool) return;
+
+    if (pool->threads_ativas > 1) {
+        pthread_mutex_lock(&pool->mutex);
+        pool->encerrar = 1;
+        pthread_cond_broadcast(&pool->cond_tarefa);
+        pthread_mutex_unlock(&pool->mutex);
+        for (int i = 1; i < pool->threads_ativas; i++)
+            pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->cond_tarefa);
+    pthread_cond_destroy(&pool->cond_fim);
+
+    if (pool->avaliadores) {
+        for (int i = 0; i < pool->num_threads; i++)
+            liberar_avaliador(pool->avaliadores[i]);
+    }
+    free(pool->avaliadores);
+    free(pool->geradores);
+    free(pool->threads);
+    free(pool->trabalhadores);
+    free(pool->tempos);
+    free(pool);
+}
+
+/* Cada thread recebe um bloco fixo e contíguo de espaços, de modo que o
+ * resultado depende apenas da semente e do número de threads. */
+static void tarefa_construir(void *contexto, int indice) {
+    const Construcao *c = contexto;
+    PoolThreads *pool = c->pool;
+    int n = c->total - c->primeiro;
+    int inicio = c->primeiro + (int)((long long)n * indice / pool->num_threads);
+    int fim = c->primeiro + (int)((long long)n * (indice + 1) / pool->num_threads);
+    construir_individuos(c, inicio, fim, &pool->geradores[indice], pool->avaliadores[indice],
+                         c->tempos ? c->tempos[indice] : NULL);
+}
+
+/* Modo estacionário: os filhos são montados em lotes na arena reserva (em
+ * paralelo com `pool`) a partir da população atual, que fica intacta
+ * durante o lote, e então substituem os piores no lugar, um a um, guiados
+ * por um heap de máximo sobre as chaves de fitness: a raiz é sempre o pior.
+ * Um filho só entra se for melhor que ele. A pressão de seleção fica toda no
+ * operador de seleção; pares vizinhos e a amostragem universal, que dependem
+ * de uma ordem ou de somas refeitas a cada troca, dão lugar ao torneio. */
+static void substituir_piores(Arena *populacao, uint64_t *heap, const Arena *filhos) {
+    const int n = populacao->quantidade;
+    for (int i = 0; i < filhos->quantidade; i++) {
+        const No *filho = &filhos->individuos[i];
+        uint32_t chave = chave_fitness(filho->fitness);
+        if (chave >= (uint32_t)(heap[0] >> 32)) continue;
+        uint32_t pior = (uint32_t)heap[0];
+        copiar_individuo(filho, &populacao->individuos[pior]);
+        heap[0] = ((uint64_t)chave << 32) | pior;
+        heap_descer(heap, n, 0);
+    }
+}
+
+static Lista *avancar_estacionario(Lista *lista, Matriz *matriz, PoolThreads *pool, Gerador *gerador,
+                                   Avaliador *avaliador, unsigned long long (*tempos)[TELEMETRIA_TOTAL_ETAPAS],
+                                   int num_tempos) {
+    Arena *populacao = &lista->atual;
+    const int n = populacao->quantidade;
+    if (n == 0) return NULL;
+
+    Medicao medicao;
+    iniciar_medicao(lista, matriz, tempos, num_tempos, &medicao);
+    if (!ranking_reservar(&lista->ranking, n)) return NULL;
+    uint64_t *heap = lista->ranking.entradas;
+    for (int i = 0; i < n; i++)
+        heap[i] = ((uint64_t)chave_fitness(populacao->individuos[i].fitness) << 32) | (uint32_t)i;
+    for (int i = n / 2 - 1; i >= 0; i--)
+        heap_descer(heap, n, i);
+    medir_ordenacao(&medicao);
+
+    Configuracao config = lista->config;
+    if (config.selecao == SELECAO_VIZINHOS || config.selecao == SELECAO_AMOSTRAGEM)
+        config.selecao = SELECAO_TORNEIO;
+
+    Construcao c;
+    memset(&c, 0, sizeof(c));
+    c.origem = populacao;
+    c.destino = &lista->reserva;
+    c.matriz = matriz;
+    c.pool = pool;
+    c.config = &config;
+    c.tempos = medicao.tempos;
+
+    for (int restantes = config.tamanho_populacao - config.elite; restantes > 0; restantes -= c.total) {
+        c.total = c.filhos = restantes < config.lote_estacionario ? restantes : config.lote_estacionario;
+        lista->reserva.quantidade = 0;
+        if (!arena_reservar(&lista->reserva, c.total)) return NULL;
+        while (lista->reserva.quantidade < c.total)
+            arena_novo_individuo(&lista->reserva);
+
+        if (pool)
+            pool_executar(pool, tarefa_construir, &c);
+        else
+            construir_individuos(&c, 0, c.total, gerador, avaliador, medicao.tempos ? medicao.tempos[0] : NULL);
+
+        unsigned long long t = medicao.tempos ? agora_ns() : 0;
+        substituir_piores(populacao, heap, &lista->reserva);
+        if (medicao.tempos) marcar_etapa(medicao.tempos[0], TELEMETRIA_REPOSICAO, &t);
+    }
+    concluir_medicao(lista, matriz, &medicao);
+    return lista;
+}
+
+/* Uma geração serial com gerador e avaliador explícitos: é o corpo de
+ * nova_geracao() e de cada ilha do arquipélago. */
+static Lista *avancar_lista(Lista *geracao_atual, Matriz *matriz, Gerador *gerador, Avaliador *avaliador) {
+    unsigned long long tempos[1][TELEMETRIA_TOTAL_ETAPAS];
+    if (geracao_atual->config.lote_estacionario > 0)
+        return avancar_estacionario(geracao_atual, matriz, NULL, gerador, avaliador, tempos, 1);
+
+    Medicao medicao;
+    iniciar_medicao(geracao_atual, matriz, tempos, 1, &medicao);
+
+    ordenar_parcial_por_fitness(geracao_atual, melhores_necessarios(&geracao_atual->config));
+    medir_ordenacao(&medicao);
+
+    // Monta a próxima geração na arena reserva e troca os buffers
+    if (!construir_geracao(&geracao_atual->atual, &geracao_atual->reserva, &geracao_atual->ranking, matriz,
+                           &geracao_atual->config, gerador, avaliador, medicao.tempos))
+        return NULL;
+
+    trocar_arenas(geracao_atual);
+    concluir_medicao(geracao_atual, matriz, &medicao);
+    return geracao_atual;
+}
+
+Lista* nova_geracao(Lista *geracao_atual, Matriz *matriz) {
+    if (geracao_atual == NULL || matriz == NULL) return NULL;
+
+    Avaliador *avaliador = avaliador_da_matriz(matriz);
+    if (!avaliador) return NULL;
+    return avancar_lista(geracao_atual, matriz, &gerador_global, avaliador);
+}
+
+Lista *nova_geracao_paralela(Lista *geracao_atual, PoolThreads *pool) {
+    if (geracao_atual == NULL || pool == NULL) return NULL;
+    if (geracao_atual->config.lote_estacionario > 0)
+        return avancar_estacionario(geracao_atual, pool->matriz, pool, NULL, NULL, pool->tempos, pool->num_threads);
+
+    Medicao medicao;
+    iniciar_medicao(geracao_atual, pool->matriz, pool->tempos, pool->num_threads, &medicao);
+
+    ordenar_parcial_por_fitness(geracao_atual, melhores_necessarios(&geracao_atual->config));
+    medir_ordenacao(&medicao);
+
+    Construcao c;
+    if (!preparar_geracao(&geracao_atual->atual, &geracao_atual->reserva, &geracao_atual->ranking, pool->matriz,
+                          &geracao_atual->config, &pool->geradores[0], medicao.tempos, &c))
+        return NULL;
+    c.pool = pool;
+    pool_executar(pool, tarefa_construir, &c);
+
+    trocar_arenas(geracao_atual);
+    concluir_medicao(geracao_atual, pool->matriz, &medicao);
+    return geracao_atual;
+}
+
+/* Fila circular de migrantes de uma ilha para a vizinha, sem travas: só a
+ * ilha de origem avança `cauda` e só a de destino avança `cabeca`. Os
+ * espaços são indivíduos pré-alocados de uma arena de tamanho fixo. */
+typedef struct _anel_migracao {
+    Arena espacos;
+    _Alignas(64) atomic_uint cabeca;
+    _Alignas(64) atomic_uint cauda;
+} AnelMigracao;
+
+struct _arquipelago {
+    Matriz *matriz;
+    Configuracao config;
+    int num_ilhas;
+    int geracoes_feitas;
+    int geracoes_pedidas;
+    Lista **ilhas;
+    AnelMigracao *aneis;        /* aneis[i] leva da ilha i para a ilha (i + 1) % num_ilhas */
+    PoolThreads *pool;          /* uma thread, um gerador e um avaliador por ilha */
+    atomic_int falhas;
+};
+
+static int anel_iniciar(AnelMigracao *anel, const Configuracao *config) {
+    anel->espacos.compacta = config->genoma_compacto ? 1 : 0;
+    anel->espacos.tam_max = tam_max_genotipo(config);
+    int capacidade = 4 * config->migrantes;
+    if (!arena_reservar(&anel->espacos, capacidade)) return 0;
+    for (int i = 0; i < capacidade; i++)
+        arena_novo_individuo(&anel->espacos);
+    atomic_init(&anel->cabeca, 0u);
+    atomic_init(&anel->cauda, 0u);
+    return 1;
+}
+
+/* Copia até `n` indivíduos para o anel; com o anel cheio, o excedente é
+ * descartado em vez de esperar pela vizinha. */
+static void anel_enviar(AnelMigracao *anel, const No *individuos, int n) {
+    unsigned capacidade = (unsigned)anel->espacos.quantidade;
+    unsigned cauda = atomic_load_explicit(&anel->cauda, memory_order_relaxed);
+    unsigned cabeca = atomic_load_explicit(&anel->cabeca, memory_order_acquire);
+    for (int i = 0; i < n && cauda - cabeca < capacidade; i++, cauda++)
+        copiar_individuo(&individuos[i], &anel->espacos.individuos[cauda % capacidade]);
+    atomic_store_explicit(&anel->cauda, cauda, memory_order_release);
+}
+
+/* Retira do anel até `max` migrantes, gravando-os a partir de `destino`;
+ * retorna quantos foram recebidos. */
+static int anel_receber(AnelMigracao *anel, No *destino, int max) {
+    unsigned capacidade = (unsigned)anel->espacos.quantidade;
+    unsigned cabeca = atomic_load_explicit(&anel->cabeca, memory_order_relaxed);
+    unsigned cauda = atomic_load_explicit(&anel->cauda, memory_order_acquire);
+    int n = 0;
+    for (; n < max && cabeca != cauda; n++, cabeca++)
+        copiar_individuo(&anel->espacos.individuos[cabeca % capacidade], &destino[n]);
+    atomic_store_explicit(&anel->cabeca, cabeca, memory_order_release);
+    return n;
+}
+
+/* Envia os melhores da ilha à vizinha e recebe os que chegaram da ilha
+ * anterior; os migrantes substituem os últimos indivíduos, que vêm dos
+ * passeios aleatórios, sem tocar na elite. */
+static void migrar(Arquipelago *a, int indice) {
+    Lista *ilha = a->ilhas[indice];
+    int migrantes = a->config.migrantes;
+    if (migrantes > ilha->atual.quantidade) migrantes = ilha->atual.quantidade;
+
+    // No modo estacionário a ordem da arena é arbitrária: ordena toda a
+    // população para que os últimos, substituídos pelos migrantes, sejam os piores
+    ordenar_parcial_por_fitness(ilha, ilha->config.lote_estacionario > 0 ? ilha->atual.quantidade : migrantes);
+    anel_enviar(&a->aneis[indice], ilha->atual.individuos, migrantes);
+
+    int livres = ilha->atual.quantidade - a->config.elite;
+    if (livres > migrantes) livres = migrantes;
+    if (livres <= 0) return;
+    int anterior = (indice + a->num_ilhas - 1) % a->num_ilhas;
+    anel_receber(&a->aneis[anterior], &ilha->atual.individuos[ilha->atual.quantidade - livres], livres);
+}
+
+static void tarefa_povoar(void *contexto, int indice) {
+    Arquipelago *a = contexto;
+    Lista *ilha = a->ilhas[indice];
+    if (!arena_insere_elementos(&ilha->atual, a->matriz, a->config.tamanho_populacao, &ilha->config,
+                                &a->pool->geradores[indice], a->pool->avaliadores[indice]))
+        atomic_fetch_add(&a->falhas, 1);
+}
+
+/* Cada ilha evolui sem sincronizar com as outras; o único contato é a
+ * migração pelos anéis a cada `intervalo_migracao` gerações. */
+static void tarefa_ilha(void *contexto, int indice) {
+    Arquipelago *a = contexto;
+    Lista *ilha = a->ilhas[indice];
+    Gerador *gerador = &a->pool->geradores[indice];
+    Avaliador *avaliador = a->pool->avaliadores[indice];
+    int intervalo = a->config.intervalo_migracao;
+
+    for (int g = 0; g < a->geracoes_pedidas; g++) {
+        int geracao = a->geracoes_feitas + g;
+        if (intervalo > 0 && a->config.migrantes > 0 && geracao > 0 && geracao % intervalo == 0)
+            migrar(a, indice);
+        if (!avancar_lista(ilha, a->matriz, gerador, avaliador)) {
+            atomic_fetch_add(&a->falhas, 1);
+            return;
+        }
+    }
+}
+
+Arquipelago *cria_arquipelago(Matriz *matriz, const Configuracao *config) {
+    if (!matriz || !validar_configuracao(config)) return NULL;
+    if (config->ilhas < 1) {
+        printf("O arquipelago precisa de ao menos uma ilha\n");
+        return NULL;
+    }
+    Arquipelago *a = calloc(1, sizeof(Arquipelago));
+    if (!a) return NULL;
+    a->matriz = matriz;
+    a->config = *config;
+    a->num_ilhas = config->ilhas;
+    atomic_init(&a->falhas, 0);
+
+    a->ilhas = calloc((size_t)a->num_ilhas, sizeof(Lista *));
+    a->aneis = calloc((size_t)a->num_ilhas, sizeof(AnelMigracao));
+    if (!a->ilhas || !a->aneis) {
+        printf("Erro ao alocar o arquipelago\n");
+        liberar_arquipelago(a);
+        return NULL;
+    }
+    for (int i = 0; i < a->num_ilhas; i++) {
+        a->ilhas[i] = cria_lista_configurada(config);
+        if (!a->ilhas[i] || (config->migrantes > 0 && !anel_iniciar(&a->aneis[i], config))) {
+            liberar_arquipelago(a);
+            return NULL;
+        }
+    }
+    a->pool = cria_pool_threads(matriz, a->num_ilhas, config->semente);
+    if (!a->pool) {
+        liberar_arquipelago(a);
+        return NULL;
+    }
+
+    pool_executar(a->pool, tarefa_povoar, a);
+    if (atomic_load(&a->falhas) > 0) {
+        liberar_arquipelago(a);
+        return NULL;
+    }
+    return a;
+}
+
+int evoluir_arquipelago(Arquipelago *arquipelago, int geracoes) {
+    if (!arquipelago || geracoes < 0) return 0;
+    arquipelago->geracoes_pedidas = geracoes;
+    pool_executar(arquipelago->pool, tarefa_ilha, arquipelago);
+    arquipelago->geracoes_feitas += geracoes;
+    return atomic_load(&arquipelago->falhas) == 0;
+}
+
+int numero_ilhas(const Arquipelago *arquipelago) {
+    return arquipelago ? arquipelago->num_ilhas : 0;
+}
+
+Lista *obter_ilha(Arquipelago *arquipelago, int indice) {
+    if (!arquipelago || indice < 0 || indice >= arquipelago->num_ilhas) return NULL;
+    return arquipelago->ilhas[indice];
+}
+
+void liberar_arquipelago(Arquipelago *arquipelago) {
+    if (!arquipelago) return;
+
+    liberar_pool_threads(arquipelago->pool);
+    if (arquipelago->ilhas) {
+        for (int i = 0; i < arquipelago->num_ilhas; i++)
+            liberar_lista(arquipelago->ilhas[i]);
+    }
+    if (arquipelago->aneis) {
+        for (int i = 0; i < arquipelago->num_ilhas; i++)
+            arena_liberar(&arquipelago->aneis[i].espacos);
+    }
+    free(arquipelago->ilhas);
+    free(arquipelago->aneis);
+    free(arquipelago);
+}
+
+/* ---- Controle da execução ---- */
+
+/* A mutação adaptativa multiplica a taxa por FATOR_MUTACAO_ADAPTATIVA a
+ * cada geração sem melhora, até PISO_MUTACAO_ADAPTATIVA vezes a original.
+ * Ela desce em vez de subir: aqui a maior parte das mutações põe um
+ * movimento contra a parede e corta o filho, e com a população parada
+ * compensa preservar os prefixos herdados. */
+#define FATOR_MUTACAO_ADAPTATIVA 0.8f
+#define PISO_MUTACAO_ADAPTATIVA 0.25f
+
+struct _controlador {
+    const Matriz *matriz;
+    Configuracao config;        /* valores originais dos cronogramas */
+    EstadoExecucao estado;
+    int iniciado;
+    EstadoExecucao anterior;    /* estado e iniciado antes da última chamada a controlar() */
+    int anterior_iniciado;
+    unsigned long long inicio_ns;
+    CriterioParada criterio;
+    void *contexto;
+};
+
+Controlador *cria_controlador(const Matriz *matriz, const Configuracao *config) {
+    if (!matriz || !validar_configuracao(config)) return NULL;
+    Controlador *c = calloc(1, sizeof(Controlador));
+    if (!c) return NULL;
+    c->matriz = matriz;
+    c->config = *config;
+    c->estado.taxa_mutacao = config->taxa_mutacao;
+    c->estado.tamanho_populacao = config->tamanho_populacao;
+    c->inicio_ns = agora_ns();
+    return c;
+}
+
+void definir_criterio_parada(Controlador *controlador, CriterioParada criterio, void *contexto) {
+    if (!controlador) return;
+    controlador->criterio = criterio;
+    controlador->contexto = contexto;
+}
+
+static MotivoParada decidir_parada(Controlador *c, int geracao) {
+    const Configuracao *config = &c->config;
+    const EstadoExecucao *e = &c->estado;
+    if (config->parar_no_objetivo && e->no_objetivo > 0) return PARADA_OBJETIVO;
+    if (config->geracoes_sem_melhora > 0 && e->geracoes_sem_melhora >= config->geracoes_sem_melhora)
+        return PARADA_ESTAGNACAO;
+    if (config->tempo_limite > 0.0 && e->segundos >= config->tempo_limite) return PARADA_TEMPO;
+    if (config->max_avaliacoes > 0 && e->avaliacoes >= config->max_avaliacoes) return PARADA_AVALIACOES;
+    if (c->criterio && c->criterio(e, c->contexto)) return PARADA_EXTERNA;
+    if (geracao >= config->geracoes) return PARADA_GERACOES;
+    return PARADA_NENHUMA;
+}
+
+/* Atualiza o estado com as listas (uma, ou as ilhas), decide a parada e,
+ * se a execução continua, aplica os cronogramas à configuração das listas. */
+static int controlar(Controlador *c, Lista *const *listas, int n, int geracao) {
+    const Matriz *matriz = c->matriz;
+    EstadoExecucao *e = &c->estado;
+    c->anterior = *e;
+    c->anterior_iniciado = c->iniciado;
+    int vazia = 1;
+    float melhor = 0.0f;
+    e->no_objetivo = 0;
+    for (int l = 0; l < n; l++) {
+        const Arena *arena = &listas[l]->atual;
+        // A população inicial é toda avaliada; nas gerações seguintes, só a elite é copiada
+        if (!c->iniciado) {
+            if (geracao == 0) e->avaliacoes += (unsigned long long)arena->quantidade;
+        } else {
+            int elite = listas[l]->config.elite < arena->quantidade ? listas[l]->config.elite : arena->quantidade;
+            e->avaliacoes += (unsigned long long)(arena->quantidade - elite);
+        }
+        for (int i = 0; i < arena->quantidade; i++) {
+            const No *no = &arena->individuos[i];
+            if (vazia || no->fitness > melhor) melhor = no->fitness;
+            vazia = 0;
+            if (no->x == matriz->x_final && no->y == matriz->y_final) e->no_objetivo++;
+        }
+    }
+    int melhorou = !c->iniciado || (!vazia && melhor > e->melhor_fitness);
+    e->geracao = geracao;
+    if (melhorou) e->melhor_fitness = melhor;
+    e->geracoes_sem_melhora = melhorou ? 0 : e->geracoes_sem_melhora + 1;
+    e->segundos = (double)(agora_ns() - c->inicio_ns) / 1e9;
+    c->iniciado = 1;
+
+    e->motivo = decidir_parada(c, geracao);
+    if (e->motivo != PARADA_NENHUMA) return 0;
+
+    const Configuracao *config = &c->config;
+    if (config->mutacao_adaptativa) {
+        float piso = config->taxa_mutacao * PISO_MUTACAO_ADAPTATIVA;
+        e->taxa_mutacao = melhorou ? config->taxa_mutacao : e->taxa_mutacao * FATOR_MUTACAO_ADAPTATIVA;
+        if (e->taxa_mutacao < piso) e->taxa_mutacao = piso;
+    }
+    if (config->populacao_minima > 0 && config->geracoes > 0) {
+        // Tamanho da geração geracao + 1, alcançando o mínimo na última
+        long long reducao = (long long)(config->tamanho_populacao - config->populacao_minima) * (geracao + 1)
+                            / config->geracoes;
+        long long tamanho = config->tamanho_populacao - reducao;
+        e->tamanho_populacao = tamanho < config->populacao_minima ? config->populacao_minima : (int)tamanho;
+    }
+    for (int l = 0; l < n; l++) {
+        listas[l]->config.taxa_mutacao = e->taxa_mutacao;
+        listas[l]->config.tamanho_populacao = e->tamanho_populacao;
+    }
+    return 1;
+}
+
+int controlar_execucao(Controlador *controlador, Lista *lista, int geracao) {
+    if (!controlador || !lista) return 0;
+    return controlar(controlador, &lista, 1, geracao);
+}
+
+int controlar_arquipelago(Controlador *controlador, Arquipelago *arquipelago, int geracao) {
+    if (!controlador || !arquipelago) return 0;
+    return controlar(controlador, arquipelago->ilhas, arquipelago->num_ilhas, geracao);
+}
+
+const EstadoExecucao *estado_execucao(const Controlador *controlador) {
+    return controlador ? &controlador->estado : NULL;
+}
+
+const char *descrever_parada(MotivoParada motivo) {
+    switch (motivo) {
+    case PARADA_NENHUMA: return "em andamento";
+    case PARADA_GERACOES: return "numero de geracoes";
+    case PARADA_OBJETIVO: return "objetivo alcancado";
+    case PARADA_ESTAGNACAO: return "sem melhora";
+    case PARADA_TEMPO: return "tempo limite";
+    case PARADA_AVALIACOES: return "limite de avaliacoes";
+    case PARADA_EXTERNA: return "criterio externo";
+    }
+    return "desconhecido";
+}
+
+void liberar_controlador(Controlador *controlador) {
+    free(controlador);
+}
+
+/* ---- Avaliação distribuída ----
+ *
+ * Protocolo entre coordenador e trabalhadores (inteiros little-endian):
+ *   OLA:   MAGIA, TIPO_OLA, linhas, colunas, assinatura (u64) do mapa,
+ *          modo de fitness (o trabalhador passa a usar o do coordenador)
+ *          resposta: MAGIA, TIPO_OLA, 1 se o mapa é o mesmo
+ *   LOTE:  MAGIA, TIPO_LOTE, quantidade, codificação, bytes do corpo (u64)
+ *          e, no corpo, por indivíduo: tam_genotipo, totalMov, truncar e o
+ *          genótipo (palavras u64 de 32 movimentos ou uma letra por movimento)
+ *          resposta: MAGIA, TIPO_LOTE, quantidade, e por indivíduo
+ *          fitness (bits do float), tam_genotipo, totalMov, colisoes, x, y
+ * Cada trabalhador carrega o mapa uma vez e o mantém enquanto a conexão
+ * estiver aberta. */
+
+#define MAGIA_PROTOCOLO 0x31444741u  /* "AGD1" */
+#define TIPO_OLA 1u
+#define TIPO_LOTE 2u
+#define CODIFICACAO_COMPACTA 0u
+#define CODIFICACAO_LETRAS 1u
+#define MAX_LOTE_REMOTO 4096
+#define MAX_GENOTIPO_REMOTO (1 << 24)
+#define MAX_CORPO_REMOTO ((uint64_t)1 << 28)  /* 256 MB por lote, nas duas codificações */
+#define BYTES_RESULTADO 24
+
+typedef struct _buffer_rede {
+    unsigned char *dados;
+    size_t tamanho;
+    size_t capacidade;
+    size_t lido;
+} BufferRede;
+
+typedef struct _conexao {
+    int fd;
+    pid_t pid;              /* trabalhador local criado por fork(), ou 0 */
+    int inicio, quantidade; /* lote em andamento */
+    BufferRede envio;
+    BufferRede resposta;
+} Conexao;
+
+struct _distribuidor {
+    Matriz *matriz;
+    Conexao *conexoes;
+    int num_conexoes;
+};
+
+static int buffer_reservar(BufferRede *b, size_t extra) {
+    if (b->tamanho + extra <= b->capacidade) return 1;
+    size_t capacidade = b->capacidade ? b->capacidade : 4096;
+    while (capacidade < b->tamanho + extra) capacidade *= 2;
+    unsigned char *dados = realloc(b->dados, capacidade);
+    if (!dados) {
+        printf("Erro ao alocar buffer de rede\n");
+        return 0;
+    }
+    b->dados = dados;
+    b->capacidade = capacidade;
+    return 1;
+}
+
+static void buffer_u32(BufferRede *b, uint32_t v) {
+    for (int i = 0; i < 4; i++) b->dados[b->tamanho++] = (unsigned char)(v >> (8 * i));
+}
+
+static void buffer_u64(BufferRede *b, uint64_t v) {
+    for (int i = 0; i < 8; i++) b->dados[b->tamanho++] = (unsigned char)(v >> (8 * i));
+}
+
+static uint32_t buffer_ler_u32(BufferRede *b) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)b->dados[b->lido++] << (8 * i);
+    return v;
+}
+
+static uint64_t buffer_ler_u64(BufferRede *b) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= (uint64_t)b->dados[b->lido++] << (8 * i);
+    return v;
+}
+
+static int enviar_tudo(int fd, const unsigned char *dados, size_t n) {
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags = MSG_NOSIGNAL;
+#endif
+    while (n > 0) {
+        ssize_t r = send(fd, dados, n, flags);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return 0;
+        dados += r;
+        n -= (size_t)r;
+    }
+    return 1;
+}
+
+/* Lê exatamente `n` bytes para o fim do buffer; 0 em erro ou conexão fechada. */
+static int receber_tudo(int fd, BufferRede *b, size_t n) {
+    if (!buffer_reservar(b, n)) return 0;
+    while (n > 0) {
+        ssize_t r = recv(fd, b->dados + b->tamanho, n, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return 0;
+        b->tamanho += (size_t)r;
+        n -= (size_t)r;
+    }
+    return 1;
+}
+
+static void buffer_limpar(BufferRede *b) {
+    b->tamanho = b->lido = 0;
+}
+
+/* Identifica o mapa pelas dimensões e pelo bitset de células livres, que
+ * continua disponível mesmo depois de compactar_mapa(). */
+static uint64_t assinatura_mapa(const Matriz *matriz) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    size_t palavras = (matriz->total_celulas + 63) / 64;
+    for (size_t i = 0; i < palavras; i++) {
+        h = (h ^ matriz->livre[i]) * 0x100000001B3ull;
+        h ^= h >> 31;
+    }
+    return h ^ matriz->pos_inicial ^ ((uint64_t)matriz->pos_final << 32);
+}
+
+/* Atende um coordenador até a conexão ser fechada. */
+static int atender_conexao(Matriz *matriz, int fd) {
+    Avaliador *avaliador = cria_avaliador(matriz);
+    BufferRede entrada = {0}, saida = {0};
+    No *nos = NULL;
+    uint64_t *palavras = NULL;
+    size_t cap_nos = 0, cap_palavras = 0;
+    int ok = avaliador != NULL;
+
+    while (ok) {
+        buffer_limpar(&entrada);
+        buffer_limpar(&saida);
+        if (!receber_tudo(fd, &entrada, 8)) break;
+        uint32_t magia = buffer_ler_u32(&entrada), tipo = buffer_ler_u32(&entrada);
+        if (magia != MAGIA_PROTOCOLO) {
+            printf("Mensagem invalida do coordenador\n");
+            ok = 0;
+            break;
+        }
+        if (tipo == TIPO_OLA) {
+            if (!receber_tudo(fd, &entrada, 20)) break;
+            uint32_t linhas = buffer_ler_u32(&entrada), colunas = buffer_ler_u32(&entrada);
+            uint64_t assinatura = buffer_ler_u64(&entrada);
+            uint32_t modo = buffer_ler_u32(&entrada);
+            // Um coordenador por vez: o modo de fitness pode ser trocado sem afetar outros
+            int igual = linhas == matriz->linhas && colunas == matriz->colunas
+                        && assinatura == assinatura_mapa(matriz)
+                        && definir_modo_fitness(matriz, (ModoFitness)modo);
+            if (!buffer_reservar(&saida, 12)) break;
+            buffer_u32(&saida, MAGIA_PROTOCOLO);
+            buffer_u32(&saida, TIPO_OLA);
+            buffer_u32(&saida, (uint32_t)igual);
+            if (!enviar_tudo(fd, saida.dados, saida.tamanho) || !igual) break;
+            continue;
+        }
+        if (tipo != TIPO_LOTE || !receber_tudo(fd, &entrada, 16)) break;
+        uint32_t quantidade = buffer_ler_u32(&entrada), codificacao = buffer_ler_u32(&entrada);
+        uint64_t bytes_corpo = buffer_ler_u64(&entrada);
+        // O corpo é reservado inteiro antes de ser lido: o limite vem da
+        // codificação e da quantidade anunciadas, e nunca passa de MAX_CORPO_REMOTO
+        uint64_t max_genotipo = codificacao == CODIFICACAO_COMPACTA ? MAX_GENOTIPO_REMOTO / 32 * 8 : MAX_GENOTIPO_REMOTO;
+        uint64_t max_corpo = (uint64_t)quantidade * (12 + max_genotipo);
+        if (max_corpo > MAX_CORPO_REMOTO) max_corpo = MAX_CORPO_REMOTO;
+        if (quantidade > MAX_LOTE_REMOTO || codificacao > CODIFICACAO_LETRAS || bytes_corpo > max_corpo) {
+            printf("Lote invalido do coordenador\n");
+            ok = 0;
+            break;
+        }
+        if (!receber_tudo(fd, &entrada, (size_t)bytes_corpo)) break;
+        if (quantidade > cap_nos) {
+            No *novos = realloc(nos, quantidade * sizeof(No));
+            if (!novos) break;
+            nos = novos;
+            cap_nos = quantidade;
+        }
+        size_t necessarias = (size_t)(bytes_corpo / 8) + quantidade;
+        if (necessarias > cap_palavras) {
+            uint64_t *novas = realloc(palavras, necessarias * sizeof(uint64_t));
+            if (!novas) break;
+            palavras = novas;
+            cap_palavras = necessarias;
+        }
+
+        // Os genótipos em letras são lidos direto do buffer de entrada
+        size_t usadas = 0;
+        unsigned char truncar[MAX_LOTE_REMOTO];
+        for (uint32_t i = 0; i < quantidade && ok; i++) {
+            if (entrada.tamanho - entrada.lido < 12) {
+                ok = 0;
+                break;
+            }
+            No *no = &nos[i];
+            no->pontos = NULL;
+            no->num_pontos = 0;
+            uint32_t tam = buffer_ler_u32(&entrada);
+            no->totalMov = (int)buffer_ler_u32(&entrada);
+            truncar[i] = buffer_ler_u32(&entrada) != 0;
+            size_t bytes = codificacao == CODIFICACAO_COMPACTA ? ((size_t)tam + 31) / 32 * 8 : tam;
+            if (tam > MAX_GENOTIPO_REMOTO || entrada.tamanho - entrada.lido < bytes) {
+                ok = 0;
+                break;
+            }
+            no->tam_genotipo = no->capacidade = (int)tam;
+            no->colisoes = 0;
+            if (codificacao == CODIFICACAO_COMPACTA) {
+                no->genes = palavras + usadas;
+                no->genotipo = NULL;
+                for (size_t u = 0; u < bytes / 8; u++)
+                    palavras[usadas++] = buffer_ler_u64(&entrada);
+                if (bytes == 0) palavras[usadas++] = 0;
+            } else {
+                no->genes = NULL;
+                no->genotipo = (char *)entrada.dados + entrada.lido;
+                entrada.lido += bytes;
+            }
+        }
+        if (!ok) {
+            printf("Lote mal formado do coordenador\n");
+            break;
+        }
+
+        // Agrupa em blocos de LARGURA_LOTE com o mesmo modo de corte
+        No *bloco[LARGURA_LOTE];
+        int n = 0, modo = 0;
+        for (uint32_t i = 0; i < quantidade; i++) {
+            if (n > 0 && (truncar[i] != modo || n == LARGURA_LOTE)) {
+                avaliar_com_cache(avaliador, bloco, n, modo);
+                n = 0;
+            }
+            bloco[n++] = &nos[i];
+            modo = truncar[i];
+        }
+        if (n > 0) avaliar_com_cache(avaliador, bloco, n, modo);
+
+        if (!buffer_reservar(&saida, 12 + (size_t)quantidade * BYTES_RESULTADO)) break;
+        buffer_u32(&saida, MAGIA_PROTOCOLO);
+        buffer_u32(&saida, TIPO_LOTE);
+        buffer_u32(&saida, quantidade);
+        for (uint32_t i = 0; i < quantidade; i++) {
+            const No *no = &nos[i];
+            uint32_t bits;
+            memcpy(&bits, &no->fitness, sizeof(bits));
+            buffer_u32(&saida, bits);
+            buffer_u32(&saida, (uint32_t)no->tam_genotipo);
+            buffer_u32(&saida, (uint32_t)no->totalMov);
+            buffer_u32(&saida, (uint32_t)no->colisoes);
+            buffer_u32(&saida, (uint32_t)no->x);
+            buffer_u32(&saida, (uint32_t)no->y);
+        }
+        if (!enviar_tudo(fd, saida.dados, saida.tamanho)) break;
+    }
+
+    free(entrada.dados);
+    free(saida.dados);
+    free(nos);
+    free(palavras);
+    liberar_avaliador(avaliador);
+    return ok;
+}
+
+/* Interpreta "unix:/caminho", "host:porta" ou apenas "porta". */
+static int abrir_socket(const char *endereco, int servidor) {
+    if (strncmp(endereco, "unix:", 5) == 0) {
+        struct sockaddr_un un;
+        memset(&un, 0, sizeof(un));
+        un.sun_family = AF_UNIX;
+        if (strlen(endereco + 5) >= sizeof(un.sun_path)) {
+            printf("Caminho de socket longo demais: %s\n", endereco + 5);
+            return -1;
+        }
+        strcpy(un.sun_path, endereco + 5);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (servidor) unlink(un.sun_path);
+        int r = servidor ? bind(fd, (struct sockaddr *)&un, sizeof(un)) : connect(fd, (struct sockaddr *)&un, sizeof(un));
+        if (r != 0 || (servidor && listen(fd, 16) != 0)) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    char host[256] = "";
+    const char *porta = endereco;
+    const char *separador = strrchr(endereco, ':');
+    if (separador) {
+        size_t n = (size_t)(separador - endereco);
+        if (n >= sizeof(host)) return -1;
+        memcpy(host, endereco, n);
+        host[n] = '\0';
+        porta = separador + 1;
+    }
+    struct addrinfo dicas, *resultado, *a;
+    memset(&dicas, 0, sizeof(dicas));
+    dicas.ai_family = AF_UNSPEC;
+    dicas.ai_socktype = SOCK_STREAM;
+    dicas.ai_flags = servidor ? AI_PASSIVE : 0;
+    if (getaddrinfo(host[0] && strcmp(host, "*") != 0 ? host : NULL, porta, &dicas, &resultado) != 0) {
+        printf("Endereco invalido: %s\n", endereco);
+        return -1;
+    }
+    int fd = -1;
+    for (a = resultado; a && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        int um = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+        int r;
+        if (servidor) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+            r = bind(fd, a->ai_addr, a->ai_addrlen) == 0 && listen(fd, 16) == 0 ? 0 : -1;
+        } else {
+            r = connect(fd, a->ai_addr, a->ai_addrlen);
+        }
+        if (r != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(resultado);
+    return fd;
+}
+
+int servir_avaliacao(Matriz *matriz, const char *endereco) {
+    if (!matriz || !endereco) return 0;
+    int servidor = abrir_socket(endereco, 1);
+    if (servidor < 0) {
+        printf("Falha ao escutar em %s\n", endereco);
+        return 0;
+    }
+    // Um coordenador por vez; ao fechar a conexão, espera o próximo
+    for (;;) {
+        int fd = accept(servidor, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            printf("Falha ao aceitar conexao\n");
+            close(servidor);
+            return 0;
+        }
+        int um = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+        atender_conexao(matriz, fd);
+        close(fd);
+    }
+}
+
+static int cumprimentar(const Matriz *matriz, Conexao *c) {
+    BufferRede *b = &c->envio;
+    buffer_limpar(b);
+    if (!buffer_reservar(b, 28)) return 0;
+    buffer_u32(b, MAGIA_PROTOCOLO);
+    buffer_u32(b, TIPO_OLA);
+    buffer_u32(b, matriz->linhas);
+    buffer_u32(b, matriz->colunas);
+    buffer_u64(b, assinatura_mapa(matriz));
+    buffer_u32(b, (uint32_t)matriz->modo_fitness);
+    buffer_limpar(&c->resposta);
+    if (!enviar_tudo(c->fd, b->dados, b->tamanho) || !receber_tudo(c->fd, &c->resposta, 12))
+        return 0;
+    uint32_t magia = buffer_ler_u32(&c->resposta), tipo = buffer_ler_u32(&c->resposta);
+    if (magia != MAGIA_PROTOCOLO || tipo != TIPO_OLA || buffer_ler_u32(&c->resposta) != 1) {
+        printf("O trabalhador usa um mapa diferente\n");
+        return 0;
+    }
+    return 1;
+}
+
+static Distribuidor *distribuidor_alocar(Matriz *matriz, int n) {
+    Distribuidor *d = calloc(1, sizeof(Distribuidor));
+    if (!d) return NULL;
+    d->matriz = matriz;
+    d->conexoes = calloc((size_t)n, sizeof(Conexao));
+    if (!d->conexoes) {
+        free(d);
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) d->conexoes[i].fd = -1;
+    return d;
+}
+
+Distribuidor *cria_distribuidor(Matriz *matriz, const char *enderecos) {
+    if (!matriz || !enderecos || !*enderecos) return NULL;
+    int n = 1;
+    for (const char *c = enderecos; *c; c++) n += *c == ',';
+    Distribuidor *d = distribuidor_alocar(matriz, n);
+    if (!d) return NULL;
+
+    const char *inicio = enderecos;
+    for (int i = 0; i < n; i++) {
+        size_t tam = strcspn(inicio, ",");
+        char endereco[512];
+        if (tam >= sizeof(endereco)) tam = sizeof(endereco) - 1;
+        memcpy(endereco, inicio, tam);
+        endereco[tam] = '\0';
+        inicio += tam + (inicio[tam] == ',');
+
+        Conexao *c = &d->conexoes[d->num_conexoes];
+        c->fd = abrir_socket(endereco, 0);
+        d->num_conexoes++;
+        if (c->fd < 0 || !cumprimentar(matriz, c)) {
+            printf("Falha ao conectar ao trabalhador %s\n", endereco);
+            liberar_distribuidor(d);
+            return NULL;
+        }
+    }
+    return d;
+}
+
+Distribuidor *cria_distribuidor_local(Matriz *matriz, int num_trabalhadores) {
+    if (!matriz || num_trabalhadores < 1) return NULL;
+    Distribuidor *d = distribuidor_alocar(matriz, num_trabalhadores);
+    if (!d) return NULL;
+
+    fflush(stdout);
+    for (int i = 0; i < num_trabalhadores; i++) {
+        int par[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, par) != 0) {
+            printf("Falha ao criar socket local\n");
+            liberar_distribuidor(d);
+            return NULL;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            printf("Falha ao criar trabalhador local\n");
+            close(par[0]);
+            close(par[1]);
+            liberar_distribuidor(d);
+            return NULL;
+        }
+        if (pid == 0) {
+            // As pontas dos trabalhadores anteriores precisam fechar aqui, ou
+            // eles nunca veriam o fim da conexão
+            for (int j = 0; j < d->num_conexoes; j++) close(d->conexoes[j].fd);
+            close(par[0]);
+            int ok = atender_conexao(matriz, par[1]);
+            _exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        close(par[1]);
+        Conexao *c = &d->conexoes[d->num_conexoes++];
+        c->fd = par[0];
+        c->pid = pid;
+        if (!cumprimentar(matriz, c)) {
+            liberar_distribuidor(d);
+            return NULL;
+        }
+    }
+    return d;
+}
+
+int numero_trabalhadores(const Distribuidor *distribuidor) {
+    return distribuidor ? distribuidor->num_conexoes : 0;
+}
+
+/* Bytes de um indivíduo no corpo do lote. */
+static size_t bytes_remotos(const No *no) {
+    return 12 + (no->genes ? ((size_t)no->tam_genotipo + 31) / 32 * 8 : (size_t)no->tam_genotipo);
+}
+
+static int montar_lote(Conexao *c, No *const *nos, int n, int filhos) {
+    BufferRede *b = &c->envio;
+    int compacta = n > 0 && nos[0]->genes != NULL;
+    size_t corpo = 0;
+    for (int i = 0; i < n; i++)
+        corpo += bytes_remotos(nos[i]);
+
+    buffer_limpar(b);
+    if (!buffer_reservar(b, 24 + corpo)) return 0;
+    buffer_u32(b, MAGIA_PROTOCOLO);
+    buffer_u32(b, TIPO_LOTE);
+    buffer_u32(b, (uint32_t)n);
+    buffer_u32(b, compacta ? CODIFICACAO_COMPACTA : CODIFICACAO_LETRAS);
+    buffer_u64(b, corpo);
+    for (int i = 0; i < n; i++) {
+        const No *no = nos[i];
+        buffer_u32(b, (uint32_t)no->tam_genotipo);
+        buffer_u32(b, (uint32_t)no->totalMov);
+        buffer_u32(b, i < filhos);
+        if (compacta) {
+            int palavras = (no->tam_genotipo + 31) / 32;
+            for (int p = 0; p < palavras; p++) {
+                uint64_t palavra = no->genes[p];
+                int resto = no->tam_genotipo - p * 32;
+                if (resto < 32) palavra &= ((uint64_t)1 << (2 * resto)) - 1;
+                buffer_u64(b, palavra);
+            }
+        } else {
+            memcpy(b->dados + b->tamanho, no->genotipo, (size_t)no->tam_genotipo);
+            b->tamanho += (size_t)no->tam_genotipo;
+        }
+    }
+    return 1;
+}
+
+static int ler_resultados(Conexao *c, No *const *nos, int n) {
+    BufferRede *b = &c->resposta;
+    buffer_limpar(b);
+    if (!receber_tudo(c->fd, b, 12)) return 0;
+    uint32_t magia = buffer_ler_u32(b), tipo = buffer_ler_u32(b), quantidade = buffer_ler_u32(b);
+    if (magia != MAGIA_PROTOCOLO || tipo != TIPO_LOTE || quantidade != (uint32_t)n) return 0;
+    if (!receber_tudo(c->fd, b, (size_t)n * BYTES_RESULTADO)) return 0;
+    for (int i = 0; i < n; i++) {
+        No *no = nos[i];
+        uint32_t bits = buffer_ler_u32(b);
+        memcpy(&no->fitness, &bits, sizeof(bits));
+        int tam = (int)buffer_ler_u32(b);
+        if (tam < 0 || tam > no->tam_genotipo) return 0;
+        no->tam_genotipo = tam;
+        no->totalMov = (int)buffer_ler_u32(b);
+        no->colisoes = (int)buffer_ler_u32(b);
+        no->x = (int)buffer_ler_u32(b);
+        no->y = (int)buffer_ler_u32(b);
+    }
+    return 1;
+}
+
+/* Divide os indivíduos em rodadas de um lote por trabalhador: todos os
+ * lotes da rodada são enviados antes de ler as respostas, e nenhum
+ * trabalhador recebe um segundo lote antes de responder o primeiro. Os
+ * `filhos` primeiros são cortados como na decodificação. */
+static int distribuir_avaliacao(Distribuidor *d, No **nos, int n, int filhos) {
+    int feitos = 0;
+    while (feitos < n) {
+        int restantes = n - feitos;
+        int por_trabalhador = (restantes + d->num_conexoes - 1) / d->num_conexoes;
+        if (por_trabalhador > MAX_LOTE_REMOTO) por_trabalhador = MAX_LOTE_REMOTO;
+
+        int usados = 0;
+        for (int w = 0; w < d->num_conexoes && feitos < n; w++, usados++) {
+            Conexao *c = &d->conexoes[w];
+            c->inicio = feitos;
+            c->quantidade = n - feitos < por_trabalhador ? n - feitos : por_trabalhador;
+            // Genótipos longos encurtam o lote para caber no limite do trabalhador
+            size_t corpo = bytes_remotos(nos[feitos]);
+            for (int q = 1; q < c->quantidade; q++) {
+                corpo += bytes_remotos(nos[feitos + q]);
+                if (corpo > MAX_CORPO_REMOTO) {
+                    c->quantidade = q;
+                    break;
+                }
+            }
+            int filhos_lote = filhos - feitos;
+            if (filhos_lote < 0) filhos_lote = 0;
+            if (!montar_lote(c, nos + feitos, c->quantidade, filhos_lote)
+                || !enviar_tudo(c->fd, c->envio.dados, c->envio.tamanho)) {
+                printf("Falha ao enviar lote ao trabalhador %d\n", w);
+                return 0;
+            }
+            feitos += c->quantidade;
+        }
+        for (int w = 0; w < usados; w++) {
+            Conexao *c = &d->conexoes[w];
+            if (!ler_resultados(c, nos + c->inicio, c->quantidade)) {
+                printf("Resposta invalida do trabalhador %d\n", w);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+int avaliar_remoto(Distribuidor *distribuidor, No **individuos, int n) {
+    if (!distribuidor || !individuos || n < 0) return 0;
+    return distribuir_avaliacao(distribuidor, individuos, n, 0);
+}
+
+Lista *nova_geracao_distribuida(Lista *geracao_atual, Distribuidor *distribuidor) {
+    if (geracao_atual == NULL || distribuidor == NULL) return NULL;
+
+    unsigned long long tempos[1][TELEMETRIA_TOTAL_ETAPAS];
+    Medicao medicao;
+    iniciar_medicao(geracao_atual, distribuidor->matriz, tempos, 1, &medicao);
+
+    ordenar_parcial_por_fitness(geracao_atual, melhores_necessarios(&geracao_atual->config));
+    medir_ordenacao(&medicao);
+
+    // Constrói a geração inteira aqui e só então a envia para avaliação
+    Construcao c;
+    if (!preparar_geracao(&geracao_atual->atual, &geracao_atual->reserva, &geracao_atual->ranking,
+                          distribuidor->matriz, &geracao_atual->config, &gerador_global, medicao.tempos, &c))
+        return NULL;
+    // Aqui o avaliador só empresta ao cruzamento posicional os buffers do tamanho do mapa
+    Avaliador *rascunho = geracao_atual->config.crossover == CROSSOVER_POSICIONAL
+                              ? avaliador_da_matriz(distribuidor->matriz) : NULL;
+    c.avaliacao_remota = 1;
+    construir_individuos(&c, c.primeiro, c.total, &gerador_global, rascunho, medicao.tempos ? medicao.tempos[0] : NULL);
+
+    int total = c.total - c.primeiro;
+    No **nos = malloc((size_t)(total > 0 ? total : 1) * sizeof(No *));
+    uint64_t *chaves = malloc((size_t)(c.filhos > 0 ? c.filhos : 1) * sizeof(uint64_t));
+    if (!nos || !chaves) {
+        free(nos);
+        free(chaves);
+        return NULL;
+    }
+    unsigned long long t = medicao.tempos ? agora_ns() : 0;
+    // Filhos já vistos no cache não vão aos trabalhadores; os filhos
+    // continuam antes dos passeios em `nos`
+    CacheFitness *cache = distribuidor->matriz->cache;
+    int n = 0, filhos = 0;
+    for (int i = 0; i < total; i++) {
+        No *no = &c.destino->individuos[c.primeiro + i];
+        if (i < c.filhos && cache) {
+            uint64_t chave = chave_cache(no);
+            if (consultar_cache(cache, chave, no)) continue;
+            chaves[filhos] = chave;
+        }
+        if (i < c.filhos) filhos++;
+        nos[n++] = no;
+    }
+    int ok = distribuir_avaliacao(distribuidor, nos, n, filhos);
+    if (ok && cache) {
+        for (int i = 0; i < filhos; i++)
+            inserir_cache(cache, chaves[i], nos[i]);
+        atomic_fetch_add_explicit(&cache->consultas, (unsigned long long)c.filhos, memory_order_relaxed);
+        atomic_fetch_add_explicit(&cache->acertos, (unsigned long long)(c.filhos - filhos), memory_order_relaxed);
+        atomic_fetch_add_explicit(&cache->insercoes, (unsigned long long)filhos, memory_order_relaxed);
+    }
+    if (medicao.tempos) marcar_etapa(medicao.tempos[0], TELEMETRIA_AVALIACAO, &t);
+    free(nos);
+    free(chaves);
+    if (!ok) return NULL;
+
+    trocar_arenas(geracao_atual);
+    concluir_medicao(geracao_atual, distribuidor->matriz, &medicao);
+    return geracao_atual;
+}
+
+void liberar_distribuidor(Distribuidor *distribuidor) {
+    if (!distribuidor) return;
+
+    for (int i = 0; i < distribuidor->num_conexoes; i++) {
+        Conexao *c = &distribuidor->conexoes[i];
+        if (c->fd >= 0) close(c->fd);
+        if (c->pid > 0) waitpid(c->pid, NULL, 0);
+        free(c->envio.dados);
+        free(c->resposta.dados);
+    }
+    free(distribuidor->conexoes);
+    free(distribuidor);
+}
+
+void liberar_lista(Lista *lista) {
+    if (!lista) return;
+
+    arena_liberar(&lista->atual);
+    arena_liberar(&lista->reserva);
+    ranking_liberar(&lista->ranking);
+    free(lista);
+}
+
+void compactar_mapa(Matriz *matriz) {
+    if (!matriz) return;
+    // Em um mapa binário o mapeamento guarda o próprio bitset, e não há texto a descartar
+    if (no_mapeamento(matriz, matriz->livre)) return;
+    desmapear_arquivo(matriz);
+}
+
+void liberar_matriz(Matriz *matriz) {
+    if (!matriz) return;
+
+    if (!no_mapeamento(matriz, matriz->livre)) free(matriz->livre);
+    if (!no_mapeamento(matriz, matriz->vizinhanca)) free(matriz->vizinhanca);
+    if (!no_mapeamento(matriz, matriz->distancia)) free(matriz->distancia);
+    desmapear_arquivo(matriz);
+    liberar_avaliador(matriz->avaliador);
+    liberar_cache(matriz->cache);
+    free(matriz);
+}
+
+void iterar_lista(Lista *lista, void (*callback)(No *no, void *contexto), void *contexto) {
+    if (!lista || !callback) return;
+    for (int i = 0; i < lista->atual.quantidade; i++)
+        callback(&lista->atual.individuos[i], contexto);
+}
+
+void salvar_individuo_csv(No *no, void *contexto) {
+    FILE *arquivo = (FILE *)contexto;
+    if (!arquivo || !no) return;
+
+    // Genótipo entre aspas, montado em blocos em vez de um fputc por movimento
+    char bloco[256];
+    int n = 0;
+    bloco[n++] = '"';
+    for (int i = 0; i < no->tam_genotipo; i++) {
+        if (n == (int)sizeof(bloco)) {
+            fwrite(bloco, 1, (size_t)n, arquivo);
+            n = 0;
+        }
+        bloco[n++] = letra_gene(no, i);
+    }
+    fwrite(bloco, 1, (size_t)n, arquivo);
+    fputs("\",", arquivo);
+
+    fprintf(arquivo, "%.2f,%d,%d,%d,%d\n", no->fitness, no->totalMov, no->colisoes, no->x, no->y);
+}
+
+void salvar_lista_csv(Lista *lista, const char *nome_arquivo) {
+    FILE *arquivo = fopen(nome_arquivo, "w");
+    if (!arquivo) {
+        printf("Erro ao abrir o arquivo CSV para escrita.\n");
+        return;
+    }
+
+    // Cabeçalho CSV
+    fprintf(arquivo, "genotipo,fitness,totalMov,colisoes,x,y\n");
+
+    // Itera sobre a lista e grava cada indivíduo
+    iterar_lista(lista, salvar_individuo_csv, arquivo);
+
+    fclose(arquivo);
+}
+
+/* ---- Gravação contínua de populações ----
+ *
+ * gravar_populacao() apenas copia a população para um dos espaços da fila,
+ * no formato binário abaixo (inteiros little-endian), e volta; uma thread
+ * própria formata, comprime e grava os espaços em ordem. Com a fila cheia,
+ * gravar_populacao() espera um espaço ou, se o gravador descarta, guarda o
+ * número da geração e a grava sem indivíduos na próxima captura (ou ao
+ * fechar), de modo que o arquivo mostra onde estão as lacunas.
+ *   arquivo: ASSINATURA_POPULACOES, VERSAO_POPULACOES (u32), e por geração:
+ *   geracao, quantidade (u32), bytes do corpo (u64) e, por indivíduo,
+ *   fitness (bits do float), tam_genotipo, totalMov, colisoes, x, y (u32)
+ *   e o genótipo em palavras u64 de 32 movimentos. Uma geração descartada
+ *   tem quantidade e corpo 0; no CSV, vira uma linha só com a geração.
+ * Com compressão, esse fluxo (ou o CSV) é dividido em blocos precedidos de
+ * ASSINATURA_BLOCOS: bytes originais e bytes comprimidos (u32; 0 se o bloco
+ * foi guardado sem compressão), seguidos dos dados. */
+
+#define ASSINATURA_POPULACOES "ALGPOPUL"
+#define VERSAO_POPULACOES 1u
+#define ASSINATURA_BLOCOS "ALGBLOCO"
+#define BLOCO_SAIDA (1 << 20)
+#define BYTES_METRICAS 24
+#define BITS_HASH_LZ 14
+
+struct _gravador {
+    FILE *arquivo;
+    FormatoSaida formato;
+    int comprimir;
+    BufferRede *espacos;                  /* gerações capturadas, em fila circular */
+    int num_espacos;
+    int descartar;                        /* com a fila cheia, descarta em vez de esperar */
+    int cabeca, ocupados;                 /* protegidos por `mutex` */
+    int encerrar;
+    int erro;
+    unsigned long long descartadas;
+    BufferRede pendentes;                 /* gerações descartadas ainda não marcadas; só de quem grava */
+    BufferRede saida;                     /* bytes formatados ainda não gravados */
+    BufferRede bloco;                     /* bloco comprimido */
+    uint32_t *tabela_lz;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_cond_t cond_livre;            /* sinalizada quando um espaço é liberado */
+};
+
+/* Comprimento estendido de uma sequência: bytes 255 seguidos do resto. */
+static int emitir_comprimento(unsigned char *saida, size_t capacidade, size_t *o, size_t resto) {
+    for (; resto >= 255; resto -= 255) {
+        if (*o >= capacidade) return 0;
+        saida[(*o)++] = 255;
+    }
+    if (*o >= capacidade) return 0;
+    saida[(*o)++] = (unsigned char)resto;
+    return 1;
 }
 
-Posicao proximo_estado_markov(Matriz *matriz, int x_atual, int y_atual) {
-    Posicao vizinhos[4];
-    int num_vizinhos = obter_vizinhos_validos(matriz, x_atual, y_atual, vizinhos, 4);
-    if (num_vizinhos == 0)
-        return (Posicao){x_atual, y_atual};
-    int escolha = rand() % num_vizinhos;
-    return vizinhos[escolha];
+/* Uma sequência no estilo LZ4: token (literais << 4 | repetição - 4),
+ * literais e, exceto na última, a distância (u16) da repetição. */
+static int emitir_sequencia(unsigned char *saida, size_t capacidade, size_t *o, const unsigned char *literais,
+                            size_t n_literais, size_t distancia, size_t repeticao) {
+    if (*o >= capacidade) return 0;
+    size_t token = *o;
+    saida[(*o)++] = (unsigned char)((n_literais < 15 ? n_literais : 15) << 4);
+    if (n_literais >= 15 && !emitir_comprimento(saida, capacidade, o, n_literais - 15)) return 0;
+    if (n_literais > capacidade - *o) return 0;
+    memcpy(saida + *o, literais, n_literais);
+    *o += n_literais;
+    if (!repeticao) return 1;
+
+    size_t extra = repeticao - 4;
+    saida[token] |= (unsigned char)(extra < 15 ? extra : 15);
+    if (capacidade - *o < 2) return 0;
+    saida[(*o)++] = (unsigned char)distancia;
+    saida[(*o)++] = (unsigned char)(distancia >> 8);
+    return extra < 15 || emitir_comprimento(saida, capacidade, o, extra - 15);
 }
 
-void cria_genotipo(Matriz *matriz, No *no) {
-    int max_tam = 10 + rand() % 91;
-    no->genotipo = malloc(sizeof(char) * max_tam);
-    if (!no->genotipo) {
-        printf("Erro ao alocar genotipo.\n");
-        no->tam_genotipo = 0;
-        return;
+/* Comprime `n` bytes em `saida`; retorna o tamanho comprimido, ou 0 se ele
+ * não for menor que o original. */
+static size_t comprimir_bloco(const unsigned char *entrada, size_t n, unsigned char *saida, uint32_t *tabela) {
+    memset(tabela, 0, sizeof(uint32_t) << BITS_HASH_LZ);
+    size_t i = 0, ancora = 0, o = 0;
+    while (i + 4 <= n) {
+        uint32_t v;
+        memcpy(&v, entrada + i, 4);
+        uint32_t h = (v * 2654435761u) >> (32 - BITS_HASH_LZ);
+        size_t candidato = tabela[h];
+        tabela[h] = (uint32_t)i + 1;
+        if (candidato && i - (candidato - 1) <= 0xFFFF && memcmp(entrada + candidato - 1, entrada + i, 4) == 0) {
+            size_t ref = candidato - 1, repeticao = 4;
+            while (i + repeticao < n && entrada[ref + repeticao] == entrada[i + repeticao]) repeticao++;
+            if (!emitir_sequencia(saida, n, &o, entrada + ancora, i - ancora, i - ref, repeticao)) return 0;
+            i += repeticao;
+            ancora = i;
+        } else {
+            i++;
+        }
     }
-    int x = matriz->x_inicial, y = matriz->y_inicial, totalMov = 0;
-    for (int i = 0; i < max_tam; i++) {
-        Posicao prox = proximo_estado_markov(matriz, x, y);
-        if (prox.x == x && prox.y == y) break; 
-
-        char direcao = 0;
-        if (prox.x == x - 1)
-            direcao = 'C'; 
-        else if (prox.x == x + 1)
-            direcao = 'B'; 
-        else if (prox.y == y - 1)
-            direcao = 'E'; 
-        else if (prox.y == y + 1)
-            direcao = 'D'; 
-        else
-            break;
+    if (!emitir_sequencia(saida, n, &o, entrada + ancora, n - ancora, 0, 0)) return 0;
+    return o < n ? o : 0;
+}
 
-        no->genotipo[totalMov++] = direcao;
-        x = prox.x;
-        y = prox.y;
+static int ler_comprimento(const unsigned char *entrada, size_t n, size_t *i, size_t *valor) {
+    unsigned char b;
+    do {
+        if (*i >= n) return 0;
+        b = entrada[(*i)++];
+        *valor += b;
+    } while (b == 255);
+    return 1;
+}
 
-        if (x == matriz->x_final && y == matriz->y_final)
-            break;
+/* Expande um bloco de comprimir_bloco(); 0 se os dados estiverem corrompidos. */
+static int descomprimir_bloco(const unsigned char *entrada, size_t n, unsigned char *saida, size_t n_saida) {
+    size_t i = 0, o = 0;
+    while (i < n) {
+        unsigned char token = entrada[i++];
+        size_t literais = token >> 4;
+        if (literais == 15 && !ler_comprimento(entrada, n, &i, &literais)) return 0;
+        if (literais > n - i || literais > n_saida - o) return 0;
+        memcpy(saida + o, entrada + i, literais);
+        i += literais;
+        o += literais;
+        if (i == n) break;
+
+        if (n - i < 2) return 0;
+        size_t distancia = entrada[i] | (size_t)entrada[i + 1] << 8;
+        i += 2;
+        size_t repeticao = (token & 15u) + 4;
+        if ((token & 15u) == 15 && !ler_comprimento(entrada, n, &i, &repeticao)) return 0;
+        if (distancia == 0 || distancia > o || repeticao > n_saida - o) return 0;
+        // A cópia é byte a byte porque origem e destino podem se sobrepor
+        for (size_t k = 0; k < repeticao; k++, o++) saida[o] = saida[o - distancia];
     }
-    if (totalMov == 0) totalMov = 1; 
-    char *temp = realloc(no->genotipo, totalMov * sizeof(char));
-    if (temp != NULL)
-        no->genotipo = temp;
-    no->totalMov = totalMov;
-    no->tam_genotipo = totalMov;
-    no->x = x;
-    no->y = y;
-    no->colisoes = 0;
+    return o == n_saida;
 }
 
-Matriz *carregar_mapa(char *arquivo) {
-    FILE *mapa = fopen(arquivo, "r");
-    if (!mapa) {
-        printf("Falha ao abrir arquivo %s\n", arquivo);
-        return NULL;
-    }
-    Matriz *matriz = malloc(sizeof(Matriz));
-    if (!matriz) {
-        fclose(mapa);
-        return NULL;
-    }
-    if (fscanf(mapa, "%u %u", &matriz->linhas, &matriz->colunas) != 2) {
-        printf("Erro ao ler dimensoes da matriz\n");
-        fclose(mapa);
-        free(matriz);
-        return NULL;
-    }
-    matriz->mapa = malloc(matriz->linhas * sizeof(char *));
-    if (!matriz->mapa) {
-        printf("Erro na alocacao do mapa\n");
-        fclose(mapa);
-        free(matriz);
-        return NULL;
-    }
-    for (unsigned int i = 0; i < matriz->linhas; ++i) {
-        matriz->mapa[i] = malloc(matriz->colunas * sizeof(char));
-        if (!matriz->mapa[i]) {
-            printf("Erro na alocacao do mapa linha %u\n", i);
-            for (unsigned int j = 0; j < i; j++)
-                free(matriz->mapa[j]);
-            free(matriz->mapa);
-            free(matriz);
-            fclose(mapa);
-            return NULL;
+/* Grava os bytes pendentes da saída em blocos de BLOCO_SAIDA; sem `tudo`,
+ * um resto menor que um bloco fica para a próxima vez. */
+static int descarregar_saida(Gravador *g, int tudo) {
+    size_t gravados = 0;
+    while (g->saida.tamanho - gravados >= BLOCO_SAIDA || (tudo && gravados < g->saida.tamanho)) {
+        size_t n = g->saida.tamanho - gravados;
+        if (n > BLOCO_SAIDA) n = BLOCO_SAIDA;
+        const unsigned char *dados = g->saida.dados + gravados;
+        if (g->comprimir) {
+            size_t comprimido = comprimir_bloco(dados, n, g->bloco.dados, g->tabela_lz);
+            unsigned char cabecalho[8];
+            for (int i = 0; i < 4; i++) {
+                cabecalho[i] = (unsigned char)(n >> (8 * i));
+                cabecalho[4 + i] = (unsigned char)(comprimido >> (8 * i));
+            }
+            if (fwrite(cabecalho, 1, 8, g->arquivo) != 8) return 0;
+            if (comprimido) dados = g->bloco.dados;
+            if (fwrite(dados, 1, comprimido ? comprimido : n, g->arquivo) != (comprimido ? comprimido : n))
+                return 0;
+        } else if (fwrite(dados, 1, n, g->arquivo) != n) {
+            return 0;
         }
+        gravados += n;
     }
+    memmove(g->saida.dados, g->saida.dados + gravados, g->saida.tamanho - gravados);
+    g->saida.tamanho -= gravados;
+    return 1;
+}
 
-    fgetc(mapa); 
+/* Formata os indivíduos de uma geração; o cursor está logo após o cabeçalho dela. */
+static int formatar_geracao_csv(Gravador *g, BufferRede *espaco, uint32_t geracao, uint32_t quantidade) {
+    for (uint32_t k = 0; k < quantidade; k++) {
+        uint32_t bits = buffer_ler_u32(espaco);
+        float fitness;
+        memcpy(&fitness, &bits, sizeof(fitness));
+        int tam = (int)buffer_ler_u32(espaco);
+        int totalMov = (int)buffer_ler_u32(espaco);
+        int colisoes = (int)buffer_ler_u32(espaco);
+        int x = (int)buffer_ler_u32(espaco);
+        int y = (int)buffer_ler_u32(espaco);
+        if (!buffer_reservar(&g->saida, (size_t)tam + 192)) return 0;
 
-    char aux[1001];
-    matriz->x_inicial = matriz->y_inicial = -1;
-    matriz->x_final = matriz->y_final = -1;
-    for (unsigned int i = 0; i < matriz->linhas; ++i) {
-        if (!fgets(aux, sizeof(aux), mapa)) {
-            printf("Erro ao ler linha %u\n", i);
-            for (unsigned int j = 0; j < matriz->linhas; j++)
-                free(matriz->mapa[j]);
-            free(matriz->mapa);
-            free(matriz);
-            fclose(mapa);
-            return NULL;
-        }
-        for (unsigned int j = 0; j < matriz->colunas; ++j) {
-            matriz->mapa[i][j] = aux[j];
-            if (aux[j] == 'S') {
-                matriz->x_inicial = i;
-                matriz->y_inicial = j;
-            } else if (aux[j] == 'E') {
-                matriz->x_final = i;
-                matriz->y_final = j;
-            }
+        char *texto = (char *)g->saida.dados + g->saida.tamanho;
+        int n = sprintf(texto, "%u,\"", geracao);
+        for (int i = 0; i < tam; i += 32) {
+            uint64_t palavra = buffer_ler_u64(espaco);
+            for (int j = 0; j < 32 && i + j < tam; j++, palavra >>= 2)
+                texto[n++] = letra_vizinho[palavra & 3u];
         }
+        n += sprintf(texto + n, "\",%.2f,%d,%d,%d,%d\n", fitness, totalMov, colisoes, x, y);
+        g->saida.tamanho += (size_t)n;
     }
-    if (matriz->x_inicial == -1 || matriz->y_inicial == -1 || matriz->x_final == -1 || matriz->y_final == -1) {
-        printf("Pontos iniciais e/ou finais nao encontrados!\n");
-        for (unsigned int i = 0; i < matriz->linhas; ++i)
-            free(matriz->mapa[i]);
-        free(matriz->mapa);
-        free(matriz);
-        fclose(mapa);
-        return NULL;
-    }
-    fclose(mapa);
-    return matriz;
+    return 1;
 }
 
-void imprimir(Lista *lista) {
-    if (!lista || !lista->inicio) {
-        printf("Lista vazia.\n");
-        return;
-    }
-    No *atual = lista->inicio;
-    printf("Individuos:\n");
-    while (atual) {
-        printf("Genotipo: ");
-        for (int i = 0; i < atual->tam_genotipo; i++)
-            printf("%c", atual->genotipo[i]);
-        printf("\nFitness: %.2f\nCoordenada final (%d, %d)\n", atual->fitness, atual->x, atual->y);
-        printf("------------------------------\n");
-        atual = atual->proximo;
+/* Converte as gerações de um espaço capturado em linhas CSV na saída. */
+static int formatar_csv(Gravador *g, BufferRede *espaco) {
+    for (espaco->lido = 0; espaco->lido < espaco->tamanho;) {
+        uint32_t geracao = buffer_ler_u32(espaco);
+        uint32_t quantidade = buffer_ler_u32(espaco);
+        buffer_ler_u64(espaco);
+        if (quantidade == 0) {
+            // Geração descartada: só o número, com as demais colunas vazias
+            if (!buffer_reservar(&g->saida, 32)) return 0;
+            g->saida.tamanho += (size_t)sprintf((char *)g->saida.dados + g->saida.tamanho, "%u,,,,,,\n", geracao);
+            continue;
+        }
+        if (!formatar_geracao_csv(g, espaco, geracao, quantidade)) return 0;
     }
+    return 1;
 }
 
-Lista *cria_lista() {
-    Lista *lista = malloc(sizeof(Lista));
-    if (!lista) return NULL;
-    lista->inicio = NULL;
-    lista->fim = NULL;
-    return lista;
+/* Formata um espaço capturado e grava os blocos completos. */
+static int processar_espaco(Gravador *g, BufferRede *espaco) {
+    int ok;
+    if (g->formato == SAIDA_CSV) {
+        ok = formatar_csv(g, espaco);
+    } else {
+        ok = buffer_reservar(&g->saida, espaco->tamanho);
+        if (ok) {
+            memcpy(g->saida.dados + g->saida.tamanho, espaco->dados, espaco->tamanho);
+            g->saida.tamanho += espaco->tamanho;
+        }
+    }
+    return ok && descarregar_saida(g, 0);
 }
 
-void insere_elementos(Lista *lista, Matriz *matriz, int num_elementos) {
-    for (int i = 0; i < num_elementos; ++i) {
-        No *node = cria_no(matriz);
-        if (!node) {
-            printf("Erro ao criar no\n");
-            return;
-        }
-        if (!lista->inicio) {
-            lista->inicio = node;
-            lista->fim = node;
-        } else {
-            lista->fim->proximo = node;
-            lista->fim = node;
+static void *executar_gravador(void *arg) {
+    Gravador *g = arg;
+    for (;;) {
+        pthread_mutex_lock(&g->mutex);
+        while (!g->ocupados && !g->encerrar)
+            pthread_cond_wait(&g->cond, &g->mutex);
+        if (!g->ocupados) {
+            pthread_mutex_unlock(&g->mutex);
+            break;
         }
+        BufferRede *espaco = &g->espacos[g->cabeca];
+        int erro = g->erro;
+        pthread_mutex_unlock(&g->mutex);
+
+        if (!erro) erro = !processar_espaco(g, espaco);
+
+        pthread_mutex_lock(&g->mutex);
+        g->erro |= erro;
+        g->cabeca = (g->cabeca + 1) % g->num_espacos;
+        g->ocupados--;
+        pthread_cond_signal(&g->cond_livre);
+        pthread_mutex_unlock(&g->mutex);
     }
+    if (!g->erro && !descarregar_saida(g, 1)) g->erro = 1;
+    return NULL;
 }
 
-float calcula_fitness(Matriz *matriz, No *no) {
-    int **visitas = malloc(matriz->linhas * sizeof(int *));
-    if (!visitas) {
-        printf("Erro ao alocar visitas\n");
-        return -INFINITY;
+Gravador *cria_gravador(const char *arquivo, FormatoSaida formato, int comprimir, int espacos, int descartar) {
+    if (!arquivo || (formato != SAIDA_CSV && formato != SAIDA_BINARIA) || espacos < 1) return NULL;
+    Gravador *g = calloc(1, sizeof(Gravador));
+    if (!g) return NULL;
+    g->formato = formato;
+    g->comprimir = comprimir != 0;
+    g->num_espacos = espacos;
+    g->descartar = descartar != 0;
+    g->espacos = calloc((size_t)espacos, sizeof(BufferRede));
+    g->arquivo = g->espacos ? fopen(arquivo, "wb") : NULL;
+    if (!g->arquivo) {
+        if (g->espacos) printf("Falha ao abrir arquivo %s\n", arquivo);
+        else printf("Erro ao criar o gravador de populacoes\n");
+        free(g->espacos);
+        free(g);
+        return NULL;
     }
-    for (unsigned int i = 0; i < matriz->linhas; i++) {
-        visitas[i] = calloc(matriz->colunas, sizeof(int));
-        if (!visitas[i]) {
-            printf("Erro ao alocar visitas linha %u\n", i);
-            for (unsigned int j = 0; j < i; j++)
-                free(visitas[j]);
-            free(visitas);
-            return -INFINITY;
+    // A gravação já é feita em blocos grandes; o buffer do FILE seria só mais uma cópia
+    setvbuf(g->arquivo, NULL, _IONBF, 0);
+
+    int ok = buffer_reservar(&g->saida, 2 * BLOCO_SAIDA);
+    if (ok && g->comprimir) {
+        g->tabela_lz = malloc(sizeof(uint32_t) << BITS_HASH_LZ);
+        ok = g->tabela_lz && buffer_reservar(&g->bloco, BLOCO_SAIDA) &&
+             fwrite(ASSINATURA_BLOCOS, 1, 8, g->arquivo) == 8;
+    }
+    if (ok && formato == SAIDA_CSV) {
+        const char *cabecalho = "geracao,genotipo,fitness,totalMov,colisoes,x,y\n";
+        memcpy(g->saida.dados, cabecalho, strlen(cabecalho));
+        g->saida.tamanho = strlen(cabecalho);
+    } else if (ok) {
+        memcpy(g->saida.dados, ASSINATURA_POPULACOES, 8);
+        g->saida.tamanho = 8;
+        buffer_u32(&g->saida, VERSAO_POPULACOES);
+    }
+    if (ok) {
+        pthread_mutex_init(&g->mutex, NULL);
+        pthread_cond_init(&g->cond, NULL);
+        pthread_cond_init(&g->cond_livre, NULL);
+        if (pthread_create(&g->thread, NULL, executar_gravador, g) != 0) {
+            pthread_mutex_destroy(&g->mutex);
+            pthread_cond_destroy(&g->cond);
+            pthread_cond_destroy(&g->cond_livre);
+            ok = 0;
         }
     }
+    if (!ok) {
+        printf("Erro ao criar o gravador de populacoes\n");
+        fclose(g->arquivo);
+        free(g->espacos);
+        free(g->saida.dados);
+        free(g->bloco.dados);
+        free(g->tabela_lz);
+        free(g);
+        return NULL;
+    }
+    return g;
+}
 
-    int x = matriz->x_inicial, y = matriz->y_inicial;
-    visitas[x][y] = 1;
-    int colisoes = 0;
-    for (int i = 0; i < no->tam_genotipo; i++) {
-        int novo_x = x, novo_y = y;
-        switch (no->genotipo[i]) {
-            case 'C':
-                if (x > 0)
-                    novo_x--;
-                break;
-            case 'B':
-                if (x < (int)matriz->linhas - 1)
-                    novo_x++;
-                break;
-            case 'E':
-                if (y > 0)
-                    novo_y--;
-                break;
-            case 'D':
-                if (y < (int)matriz->colunas - 1)
-                    novo_y++;
-                break;
-            default:
-                break;
-        }
-        if (matriz->mapa[novo_x][novo_y] == '#') {
-            colisoes++;
-            break;
-        } else {
-            x = novo_x;
-            y = novo_y;
-            visitas[x][y]++;
+/* Acrescenta a população ao buffer no formato binário de uma geração. */
+static int capturar_populacao(BufferRede *espaco, const Arena *arena, int geracao) {
+    size_t bytes = 0;
+    for (int k = 0; k < arena->quantidade; k++)
+        bytes += BYTES_METRICAS + ((size_t)arena->individuos[k].tam_genotipo + 31) / 32 * sizeof(uint64_t);
+    if (!buffer_reservar(espaco, 16 + bytes)) return 0;
+    buffer_u32(espaco, (uint32_t)geracao);
+    buffer_u32(espaco, (uint32_t)arena->quantidade);
+    buffer_u64(espaco, bytes);
+    for (int k = 0; k < arena->quantidade; k++) {
+        const No *no = &arena->individuos[k];
+        uint32_t bits;
+        memcpy(&bits, &no->fitness, sizeof(bits));
+        buffer_u32(espaco, bits);
+        buffer_u32(espaco, (uint32_t)no->tam_genotipo);
+        buffer_u32(espaco, (uint32_t)no->totalMov);
+        buffer_u32(espaco, (uint32_t)no->colisoes);
+        buffer_u32(espaco, (uint32_t)no->x);
+        buffer_u32(espaco, (uint32_t)no->y);
+        for (int i = 0; i < no->tam_genotipo; i += 32) {
+            uint64_t palavra;
+            if (no->genes) {
+                palavra = no->genes[i >> 5];
+            } else {
+                palavra = 0;
+                for (int j = 0; j < 32 && i + j < no->tam_genotipo; j++) {
+                    int codigo = codigo_letra[(unsigned char)no->genotipo[i + j]];
+                    palavra |= (uint64_t)(codigo ? codigo - 1 : 0) << (2 * j);
+                }
+            }
+            buffer_u64(espaco, palavra);
         }
-        if (x == matriz->x_final && y == matriz->y_final)
-            break;
     }
+    return 1;
+}
 
-    int penalidade_repeticao = 0;
-    for (unsigned int i = 0; i < matriz->linhas; i++) {
-        for (unsigned int j = 0; j < matriz->colunas; j++) {
-            if (visitas[i][j] > 1)
-                penalidade_repeticao += (visitas[i][j] - 1);
+/* Acrescenta ao buffer as gerações descartadas desde a última captura, cada
+ * uma como uma geração sem indivíduos. */
+static int capturar_descartes(Gravador *g, BufferRede *espaco) {
+    if (!buffer_reservar(espaco, g->pendentes.tamanho / 4 * 16)) return 0;
+    for (g->pendentes.lido = 0; g->pendentes.lido < g->pendentes.tamanho;) {
+        buffer_u32(espaco, buffer_ler_u32(&g->pendentes));
+        buffer_u32(espaco, 0);
+        buffer_u64(espaco, 0);
+    }
+    buffer_limpar(&g->pendentes);
+    return 1;
+}
+
+int gravar_populacao(Gravador *gravador, Lista *lista, int geracao) {
+    if (!gravador || !lista) return 0;
+    pthread_mutex_lock(&gravador->mutex);
+    while (!gravador->descartar && !gravador->erro && gravador->ocupados == gravador->num_espacos)
+        pthread_cond_wait(&gravador->cond_livre, &gravador->mutex);
+    int livre = !gravador->erro && gravador->ocupados < gravador->num_espacos;
+    int indice = (gravador->cabeca + gravador->ocupados) % gravador->num_espacos;
+    if (!livre) gravador->descartadas++;
+    int erro = gravador->erro;
+    pthread_mutex_unlock(&gravador->mutex);
+    if (!livre) {
+        // Marcada no arquivo junto com a próxima geração capturada, ou ao fechar
+        if (erro) return 0;
+        if (buffer_reservar(&gravador->pendentes, 4)) {
+            buffer_u32(&gravador->pendentes, (uint32_t)geracao);
+            return 0;
         }
-        free(visitas[i]);
+        pthread_mutex_lock(&gravador->mutex);
+        gravador->erro = 1;
+        pthread_mutex_unlock(&gravador->mutex);
+        return 0;
     }
-    free(visitas);
 
-    float distancia = fabsf(x - matriz->x_final) + fabsf(y - matriz->y_final);
-    float penalidade_colisao = 5.0f * colisoes;
-    float penalidade_repetida = 3.0f * penalidade_repeticao;
-    float recompensa_comprimento = 10.0f * no->totalMov + 0.1f * (no->totalMov * no->totalMov);
+    // O espaço fora do intervalo ocupado pertence só a quem grava
+    BufferRede *espaco = &gravador->espacos[indice];
+    buffer_limpar(espaco);
+    if (!capturar_descartes(gravador, espaco) || !capturar_populacao(espaco, &lista->atual, geracao)) return 0;
 
-    return 1000.0f - distancia - penalidade_colisao - penalidade_repetida + recompensa_comprimento;
+    pthread_mutex_lock(&gravador->mutex);
+    gravador->ocupados++;
+    pthread_cond_signal(&gravador->cond);
+    pthread_mutex_unlock(&gravador->mutex);
+    return 1;
 }
 
-void aplicar_mutacao(No *individuo, float taxa_mutacao) {
-    const char direcoes[] = {'C', 'B', 'D', 'E'};
-    for (int i = 0; i < individuo->tam_genotipo; i++) {
-        if ((rand() / (float)RAND_MAX) < taxa_mutacao) {
-            individuo->genotipo[i] = direcoes[rand() % 4];
-        }
+unsigned long long geracoes_descartadas(Gravador *gravador) {
+    if (!gravador) return 0;
+    pthread_mutex_lock(&gravador->mutex);
+    unsigned long long n = gravador->descartadas;
+    pthread_mutex_unlock(&gravador->mutex);
+    return n;
+}
+
+int fechar_gravador(Gravador *gravador) {
+    if (!gravador) return 0;
+    pthread_mutex_lock(&gravador->mutex);
+    gravador->encerrar = 1;
+    pthread_cond_signal(&gravador->cond);
+    pthread_mutex_unlock(&gravador->mutex);
+    pthread_join(gravador->thread, NULL);
+
+    // Descartes depois da última captura ainda não estão no arquivo
+    if (!gravador->erro && gravador->pendentes.tamanho) {
+        BufferRede *espaco = &gravador->espacos[0];
+        buffer_limpar(espaco);
+        if (!capturar_descartes(gravador, espaco) || !processar_espaco(gravador, espaco) ||
+            !descarregar_saida(gravador, 1))
+            gravador->erro = 1;
     }
+
+    int ok = !gravador->erro;
+    if (fclose(gravador->arquivo) != 0) ok = 0;
+    if (!ok) printf("Erro ao gravar as populacoes\n");
+    for (int i = 0; i < gravador->num_espacos; i++) free(gravador->espacos[i].dados);
+    free(gravador->espacos);
+    free(gravador->pendentes.dados);
+    free(gravador->saida.dados);
+    free(gravador->bloco.dados);
+    free(gravador->tabela_lz);
+    pthread_mutex_destroy(&gravador->mutex);
+    pthread_cond_destroy(&gravador->cond);
+    pthread_cond_destroy(&gravador->cond_livre);
+    free(gravador);
+    return ok;
 }
 
-void aplicar_elitismo(Lista *origem, Lista *destino, int n) {
-    No *atual = origem->inicio;
-    for (int i = 0; i < n && atual != NULL; i++) {
-        No *copia = malloc(sizeof(No));
-        if (copia == NULL) return;
-
-        copia->genotipo = malloc(atual->tam_genotipo * sizeof(char));
-        if (copia->genotipo == NULL) {
-            free(copia);
-            return;
+int descomprimir_arquivo(const char *entrada, const char *saida) {
+    FILE *origem = fopen(entrada, "rb");
+    if (!origem) {
+        printf("Falha ao abrir arquivo %s\n", entrada);
+        return 0;
+    }
+    char assinatura[8];
+    if (fread(assinatura, 1, 8, origem) != 8 || memcmp(assinatura, ASSINATURA_BLOCOS, 8) != 0) {
+        printf("Arquivo %s nao esta comprimido\n", entrada);
+        fclose(origem);
+        return 0;
+    }
+    FILE *destino = fopen(saida, "wb");
+    if (!destino) {
+        printf("Falha ao abrir arquivo %s\n", saida);
+        fclose(origem);
+        return 0;
+    }
+    unsigned char *comprimido = malloc(BLOCO_SAIDA), *original = malloc(BLOCO_SAIDA);
+    int ok = comprimido && original;
+    unsigned char cabecalho[8];
+    size_t lidos;
+    while (ok && (lidos = fread(cabecalho, 1, 8, origem)) > 0) {
+        if (lidos != 8) {
+            ok = 0;
+            break;
         }
+        size_t n = 0, c = 0;
+        for (int i = 0; i < 4; i++) {
+            n |= (size_t)cabecalho[i] << (8 * i);
+            c |= (size_t)cabecalho[4 + i] << (8 * i);
+        }
+        if (n == 0 || n > BLOCO_SAIDA || c >= n) {
+            ok = 0;
+            break;
+        }
+        unsigned char *dados = c ? comprimido : original;
+        ok = fread(dados, 1, c ? c : n, origem) == (c ? c : n) &&
+             (!c || descomprimir_bloco(comprimido, c, original, n)) &&
+             fwrite(original, 1, n, destino) == n;
+    }
+    if (ok && ferror(origem)) ok = 0;
+    if (!ok) printf("Erro ao descomprimir %s\n", entrada);
+    free(comprimido);
+    free(original);
+    fclose(origem);
+    if (fclose(destino) != 0) ok = 0;
+    return ok;
+}
 
-        copia->tam_genotipo = atual->tam_genotipo;
-        copia->totalMov = atual->totalMov;
-        copia->fitness = atual->fitness;
-        copia->x = atual->x;
-        copia->y = atual->y;
-        copia->colisoes = atual->colisoes;
-        copia->proximo = NULL;
+/* ---- Salvamento e retomada do estado ----
+ *
+ * O arquivo de estado (inteiros little-endian) guarda tudo o que a evolução
+ * consome: ASSINATURA_ESTADO, VERSAO_ESTADO, assinatura, linhas e colunas
+ * do mapa, a geração, os parâmetros de Configuracao que afetam a evolução
+ * (com a mutação e a população originais, antes dos cronogramas), o estado
+ * do controlador, os geradores (o global e os do pool, se houver) e a
+ * população no formato binário do gravador, seguidos da soma de
+ * verificação de todo o conteúdo.
+ * salvar_estado() monta o arquivo em memória; uma thread própria grava em
+ * um arquivo temporário e o renomeia, de modo que o estado anterior só é
+ * substituído por um estado completo. */
 
-        memcpy(copia->genotipo, atual->genotipo, atual->tam_genotipo * sizeof(char));
+#define ASSINATURA_ESTADO "ALGESTAD"
+#define VERSAO_ESTADO 6u
 
-        if (destino->inicio == NULL) {
-            destino->inicio = copia;
-            destino->fim = copia;
-        } else {
-            destino->fim->proximo = copia;
-            destino->fim = copia;
-        }
+struct _salvamento {
+    char *arquivo;
+    char *temporario;           /* arquivo + ".tmp" */
+    BufferRede captura;         /* estado montado por salvar_estado() */
+    BufferRede escrita;         /* estado sendo gravado pela thread */
+    int pendente;               /* `captura` aguarda a thread; protegidos por `mutex` */
+    int encerrar;
+    int erro;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
 
-        atual = atual->proximo;
+static uint64_t soma_verificacao(const unsigned char *dados, size_t n) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t palavra;
+        memcpy(&palavra, dados + i, sizeof(palavra));
+        h = (h ^ palavra) * 0x100000001B3ull;
+        h ^= h >> 31;
     }
+    for (; i < n; i++) h = (h ^ dados[i]) * 0x100000001B3ull;
+    return h;
 }
 
-void ordenar_por_fitness(Lista *lista) {
-    if (lista == NULL || lista->inicio == NULL) return;
-
-    int trocou;
-    do {
-        trocou = 0;
-        No *atual = lista->inicio;
-        No *anterior = NULL;
-
-        while (atual != NULL && atual->proximo != NULL) {
-            No *prox = atual->proximo;
-
-            if (atual->fitness < prox->fitness) {
-                if (anterior == NULL) {
-                    lista->inicio = prox;
-                } else {
-                    anterior->proximo = prox;
-                }
+static void buffer_gerador(BufferRede *b, const Gerador *gerador) {
+    for (int i = 0; i < 4; i++) buffer_u64(b, gerador->s[i]);
+}
 
-                atual->proximo = prox->proximo;
-                prox->proximo = atual;
+static void *executar_salvamento(void *arg) {
+    Salvamento *s = arg;
+    for (;;) {
+        pthread_mutex_lock(&s->mutex);
+        while (!s->pendente && !s->encerrar)
+            pthread_cond_wait(&s->cond, &s->mutex);
+        if (!s->pendente) {
+            pthread_mutex_unlock(&s->mutex);
+            break;
+        }
+        BufferRede troca = s->escrita;
+        s->escrita = s->captura;
+        s->captura = troca;
+        s->pendente = 0;
+        pthread_cond_broadcast(&s->cond);
+        pthread_mutex_unlock(&s->mutex);
 
-                trocou = 1;
-                anterior = prox;
-            } else {
-                anterior = atual;
-                atual = atual->proximo;
-            }
+        FILE *arquivo = fopen(s->temporario, "wb");
+        int ok = arquivo && fwrite(s->escrita.dados, 1, s->escrita.tamanho, arquivo) == s->escrita.tamanho &&
+                 fflush(arquivo) == 0 && fsync(fileno(arquivo)) == 0;
+        if (arquivo && fclose(arquivo) != 0) ok = 0;
+        if (ok && rename(s->temporario, s->arquivo) != 0) ok = 0;
+        if (!ok) {
+            printf("Erro ao gravar o estado em %s\n", s->arquivo);
+            pthread_mutex_lock(&s->mutex);
+            s->erro = 1;
+            pthread_mutex_unlock(&s->mutex);
         }
-    } while (trocou);
+    }
+    return NULL;
+}
 
-    No *aux = lista->inicio;
-    while (aux && aux->proximo != NULL) {
-        aux = aux->proximo;
+Salvamento *cria_salvamento(const char *arquivo) {
+    if (!arquivo) return NULL;
+    Salvamento *s = calloc(1, sizeof(Salvamento));
+    if (!s) return NULL;
+    s->arquivo = malloc(strlen(arquivo) + 1);
+    s->temporario = malloc(strlen(arquivo) + 5);
+    if (!s->arquivo || !s->temporario) {
+        free(s->arquivo);
+        free(s->temporario);
+        free(s);
+        return NULL;
+    }
+    strcpy(s->arquivo, arquivo);
+    sprintf(s->temporario, "%s.tmp", arquivo);
+    pthread_mutex_init(&s->mutex, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    if (pthread_create(&s->thread, NULL, executar_salvamento, s) != 0) {
+        printf("Erro ao criar a thread de salvamento\n");
+        pthread_mutex_destroy(&s->mutex);
+        pthread_cond_destroy(&s->cond);
+        free(s->arquivo);
+        free(s->temporario);
+        free(s);
+        return NULL;
     }
-    lista->fim = aux;
+    return s;
 }
 
-Lista* nova_geracao(Lista *geracao_atual, Matriz *matriz) {
-    if (geracao_atual == NULL || matriz == NULL) return NULL;
+/* Grava o estado do controlador como ele estava antes de olhar a geração
+ * salva: ao retomar, controlar() recebe essa geração de novo. Sem
+ * controlador, grava um que ainda não começou. */
+static void buffer_controlador(BufferRede *b, const Controlador *controlador, const Lista *lista, int geracao) {
+    EstadoExecucao vazio;
+    memset(&vazio, 0, sizeof(vazio));
+    const EstadoExecucao *e = &vazio;
+    int iniciado = 0;
+    unsigned long long ns = 0;
+    if (controlador) {
+        int olhou = controlador->iniciado && controlador->estado.geracao == geracao;
+        e = olhou ? &controlador->anterior : &controlador->estado;
+        iniciado = olhou ? controlador->anterior_iniciado : controlador->iniciado;
+        ns = agora_ns() - controlador->inicio_ns;
+    }
+    uint32_t taxa, melhor, taxa_estado;
+    memcpy(&taxa, &lista->config.taxa_mutacao, sizeof(taxa));
+    memcpy(&melhor, &e->melhor_fitness, sizeof(melhor));
+    memcpy(&taxa_estado, &e->taxa_mutacao, sizeof(taxa_estado));
+    buffer_u32(b, (uint32_t)lista->config.mutacao_adaptativa);
+    buffer_u32(b, (uint32_t)lista->config.populacao_minima);
+    buffer_u32(b, taxa);
+    buffer_u32(b, (uint32_t)lista->config.tamanho_populacao);
+    buffer_u32(b, (uint32_t)iniciado);
+    buffer_u32(b, (uint32_t)e->geracao);
+    buffer_u32(b, melhor);
+    buffer_u32(b, (uint32_t)e->geracoes_sem_melhora);
+    buffer_u32(b, (uint32_t)e->no_objetivo);
+    buffer_u64(b, e->avaliacoes);
+    buffer_u32(b, taxa_estado);
+    buffer_u32(b, (uint32_t)e->tamanho_populacao);
+    buffer_u32(b, (uint32_t)e->motivo);
+    buffer_u64(b, ns);
+}
 
-    ordenar_por_fitness(geracao_atual);
+/* Monta em `b` o conteúdo completo do arquivo de estado. */
+static int montar_estado(BufferRede *b, Lista *lista, const Matriz *matriz, const PoolThreads *pool,
+                         const Controlador *controlador, int geracao) {
+    // Os cronogramas partem dos valores originais, guardados pelo controlador
+    const Configuracao *config = controlador ? &controlador->config : &lista->config;
+    int num_geradores = pool ? pool->num_threads : 0;
+    buffer_limpar(b);
+    if (!buffer_reservar(b, 224 + (size_t)num_geradores * 32)) return 0;
+    memcpy(b->dados, ASSINATURA_ESTADO, 8);
+    b->tamanho = 8;
+    buffer_u32(b, VERSAO_ESTADO);
+    buffer_u64(b, assinatura_mapa(matriz));
+    buffer_u32(b, matriz->linhas);
+    buffer_u32(b, matriz->colunas);
+    buffer_u32(b, (uint32_t)geracao);
 
-    Lista *nova = criar_lista_com_crossover(geracao_atual, matriz);
+    uint32_t taxa, pressao;
+    memcpy(&taxa, &config->taxa_mutacao, sizeof(taxa));
+    memcpy(&pressao, &config->pressao_ranking, sizeof(pressao));
+    buffer_u32(b, (uint32_t)config->tamanho_populacao);
+    buffer_u32(b, (uint32_t)config->elite);
+    buffer_u32(b, (uint32_t)config->max_filhos);
+    buffer_u32(b, taxa);
+    buffer_u32(b, (uint32_t)config->tam_filho);
+    buffer_u32(b, (uint32_t)config->passeio_min);
+    buffer_u32(b, (uint32_t)config->passeio_max);
+    buffer_u32(b, (uint32_t)config->genoma_compacto);
+    buffer_u32(b, (uint32_t)config->modo_fitness);
+    buffer_u32(b, (uint32_t)config->selecao);
+    buffer_u32(b, (uint32_t)config->tamanho_torneio);
+    buffer_u32(b, pressao);
+    buffer_u32(b, (uint32_t)config->crossover);
+    buffer_u32(b, (uint32_t)config->lote_estacionario);
+    buffer_u32(b, (uint32_t)config->threads);
+    buffer_u64(b, config->semente);
+    buffer_controlador(b, controlador, lista, geracao);
 
-    liberar_lista(geracao_atual);
+    buffer_gerador(b, &gerador_global);
+    buffer_u32(b, (uint32_t)num_geradores);
+    for (int i = 0; i < num_geradores; i++) buffer_gerador(b, &pool->geradores[i]);
 
-    return nova;
+    if (!capturar_populacao(b, &lista->atual, geracao) || !buffer_reservar(b, 8)) return 0;
+    buffer_u64(b, soma_verificacao(b->dados, b->tamanho));
+    return 1;
 }
 
-Lista* criar_lista_com_crossover(Lista* lista, Matriz* matriz) {
-    if (lista == NULL || lista->inicio == NULL || matriz == NULL) return NULL;
+int salvar_estado(Salvamento *salvamento, Lista *lista, const Matriz *matriz, PoolThreads *pool,
+                  const Controlador *controlador, int geracao, int esperar) {
+    if (!salvamento || !lista || !matriz) return 0;
+    pthread_mutex_lock(&salvamento->mutex);
+    if (salvamento->pendente && !esperar) {
+        pthread_mutex_unlock(&salvamento->mutex);
+        return 0;
+    }
+    while (salvamento->pendente)
+        pthread_cond_wait(&salvamento->cond, &salvamento->mutex);
+    pthread_mutex_unlock(&salvamento->mutex);
 
-    const int TOTAL_INDIVIDUOS = 100;
-    const int ELITE = 5;
-    const float TAXA_MUTACAO = 0.05f;
+    // Sem estado pendente, `captura` pertence só a quem salva
+    if (!montar_estado(&salvamento->captura, lista, matriz, pool, controlador, geracao)) return 0;
 
-    Lista* nova_lista = cria_lista();
-    if (nova_lista == NULL) return NULL;
+    pthread_mutex_lock(&salvamento->mutex);
+    salvamento->pendente = 1;
+    pthread_cond_broadcast(&salvamento->cond);
+    pthread_mutex_unlock(&salvamento->mutex);
+    return 1;
+}
 
-    aplicar_elitismo(lista, nova_lista, ELITE);
+int fechar_salvamento(Salvamento *salvamento) {
+    if (!salvamento) return 0;
+    pthread_mutex_lock(&salvamento->mutex);
+    salvamento->encerrar = 1;
+    pthread_cond_broadcast(&salvamento->cond);
+    pthread_mutex_unlock(&salvamento->mutex);
+    pthread_join(salvamento->thread, NULL);
 
-    No* atual = lista->inicio;
-    int criados = 0;
+    int ok = !salvamento->erro;
+    free(salvamento->captura.dados);
+    free(salvamento->escrita.dados);
+    free(salvamento->arquivo);
+    free(salvamento->temporario);
+    pthread_mutex_destroy(&salvamento->mutex);
+    pthread_cond_destroy(&salvamento->cond);
+    free(salvamento);
+    return ok;
+}
 
-    while (atual != NULL && atual->proximo != NULL && criados < 45) {
-        No* proximo = atual->proximo;
+/* Lê o arquivo de estado inteiro e confere assinatura, versão, tamanho e
+ * soma de verificação; o cursor fica logo após a versão. */
+static int ler_arquivo_estado(const char *arquivo, BufferRede *b) {
+    FILE *origem = fopen(arquivo, "rb");
+    if (!origem) {
+        printf("Falha ao abrir arquivo %s\n", arquivo);
+        return 0;
+    }
+    int ok = fseek(origem, 0, SEEK_END) == 0;
+    long tamanho = ok ? ftell(origem) : -1;
+    ok = tamanho >= 8 + 4 + 8 && fseek(origem, 0, SEEK_SET) == 0 && buffer_reservar(b, (size_t)tamanho) &&
+         fread(b->dados, 1, (size_t)tamanho, origem) == (size_t)tamanho;
+    fclose(origem);
+    if (ok) {
+        b->tamanho = (size_t)tamanho - 8;
+        b->lido = b->tamanho;
+        ok = memcmp(b->dados, ASSINATURA_ESTADO, 8) == 0 &&
+             buffer_ler_u64(b) == soma_verificacao(b->dados, b->tamanho);
+        b->lido = 8;
+        ok = ok && buffer_ler_u32(b) == VERSAO_ESTADO;
+    }
+    if (!ok) printf("Arquivo de estado %s invalido ou corrompido\n", arquivo);
+    return ok;
+}
 
-        No* filho = malloc(sizeof(No));
-        if (filho == NULL) {
-            liberar_lista(nova_lista);
-            return NULL;
-        }
+/* Lê os parâmetros da evolução; o cursor deve estar logo após o mapa e a geração. */
+static void ler_configuracao(BufferRede *b, Configuracao *config) {
+    config->tamanho_populacao = (int)buffer_ler_u32(b);
+    config->elite = (int)buffer_ler_u32(b);
+    config->max_filhos = (int)buffer_ler_u32(b);
+    uint32_t taxa = buffer_ler_u32(b);
+    memcpy(&config->taxa_mutacao, &taxa, sizeof(taxa));
+    config->tam_filho = (int)buffer_ler_u32(b);
+    config->passeio_min = (int)buffer_ler_u32(b);
+    config->passeio_max = (int)buffer_ler_u32(b);
+    config->genoma_compacto = (int)buffer_ler_u32(b);
+    config->modo_fitness = (ModoFitness)buffer_ler_u32(b);
+    config->selecao = (ModoSelecao)buffer_ler_u32(b);
+    config->tamanho_torneio = (int)buffer_ler_u32(b);
+    uint32_t pressao = buffer_ler_u32(b);
+    memcpy(&config->pressao_ranking, &pressao, sizeof(pressao));
+    config->crossover = (ModoCrossover)buffer_ler_u32(b);
+    config->lote_estacionario = (int)buffer_ler_u32(b);
+    config->threads = (int)buffer_ler_u32(b);
+    config->semente = buffer_ler_u64(b);
+    config->mutacao_adaptativa = (int)buffer_ler_u32(b);
+    config->populacao_minima = (int)buffer_ler_u32(b);
+}
 
-        filho->genotipo = malloc(100 * sizeof(char));
-        if (filho->genotipo == NULL) {
-            free(filho);
-            liberar_lista(nova_lista);
-            return NULL;
-        }
+/* Bytes do controlador depois dos dois cronogramas lidos por ler_configuracao(). */
+#define BYTES_CONTROLADOR_ESTADO (4 + 4 + 4 + 4 + 4 + 4 + 4 + 8 + 4 + 4 + 4 + 8)
 
-        filho->totalMov = 100;
-        filho->colisoes = 0;
-        filho->tam_genotipo = 100;
-        filho->proximo = NULL;
+/* Bytes fixos entre a versão e os geradores: mapa, geração, parâmetros e controlador. */
+#define BYTES_CABECALHO_ESTADO (8 + 4 + 4 + 4 + 17 * 4 + 8 + BYTES_CONTROLADOR_ESTADO)
 
-        const char direcoes[] = {'C', 'B', 'D', 'E'};
+/* Lê o estado do controlador; a mutação e a população em uso na lista vão
+ * para `config`. */
+static void ler_controlador(BufferRede *b, Configuracao *config, EstadoExecucao *e, int *iniciado,
+                            unsigned long long *ns) {
+    uint32_t bits = buffer_ler_u32(b);
+    memcpy(&config->taxa_mutacao, &bits, sizeof(bits));
+    config->tamanho_populacao = (int)buffer_ler_u32(b);
+    *iniciado = (int)buffer_ler_u32(b);
+    e->geracao = (int)buffer_ler_u32(b);
+    bits = buffer_ler_u32(b);
+    memcpy(&e->melhor_fitness, &bits, sizeof(bits));
+    e->geracoes_sem_melhora = (int)buffer_ler_u32(b);
+    e->no_objetivo = (int)buffer_ler_u32(b);
+    e->avaliacoes = buffer_ler_u64(b);
+    bits = buffer_ler_u32(b);
+    memcpy(&e->taxa_mutacao, &bits, sizeof(bits));
+    e->tamanho_populacao = (int)buffer_ler_u32(b);
+    e->motivo = (MotivoParada)buffer_ler_u32(b);
+    *ns = buffer_ler_u64(b);
+}
 
-        int tam1 = atual->tam_genotipo < 50 ? atual->tam_genotipo : 50;
+int ler_configuracao_estado(const char *arquivo, Configuracao *config) {
+    if (!arquivo || !config) return 0;
+    BufferRede b = {0};
+    int ok = ler_arquivo_estado(arquivo, &b) && b.tamanho - b.lido >= BYTES_CABECALHO_ESTADO;
+    if (ok) {
+        b.lido += 8 + 4 + 4 + 4;
+        ler_configuracao(&b, config);
+    }
+    free(b.dados);
+    return ok;
+}
 
-        int tam2 = proximo->tam_genotipo;
-        int inicio2 = tam2 > 50 ? tam2 - 50 : 0;
-        int tam2_real = tam2 - inicio2 < 50 ? tam2 - inicio2 : 50;
+static void ler_gerador(BufferRede *b, Gerador *gerador) {
+    for (int i = 0; i < 4; i++) gerador->s[i] = buffer_ler_u64(b);
+}
 
-        for (int i = 0; i < 50; i++) {
-            filho->genotipo[i] = (i < tam1) ? atual->genotipo[i] : direcoes[rand() % 4];
+/* Recria a população gravada por capturar_populacao() na arena. */
+static int ler_populacao(BufferRede *b, Arena *arena) {
+    if (b->tamanho - b->lido < 16) return 0;
+    buffer_ler_u32(b);
+    uint32_t quantidade = buffer_ler_u32(b);
+    uint64_t bytes = buffer_ler_u64(b);
+    if (bytes != b->tamanho - b->lido || quantidade > (uint32_t)INT32_MAX ||
+        !arena_reservar(arena, (int)quantidade)) return 0;
+    for (uint32_t k = 0; k < quantidade; k++) {
+        if (b->tamanho - b->lido < BYTES_METRICAS) return 0;
+        No *no = arena_novo_individuo(arena);
+        uint32_t bits = buffer_ler_u32(b);
+        memcpy(&no->fitness, &bits, sizeof(bits));
+        no->tam_genotipo = (int)buffer_ler_u32(b);
+        no->totalMov = (int)buffer_ler_u32(b);
+        no->colisoes = (int)buffer_ler_u32(b);
+        no->x = (int)buffer_ler_u32(b);
+        no->y = (int)buffer_ler_u32(b);
+        if (no->tam_genotipo < 0 || no->tam_genotipo > no->capacidade ||
+            b->tamanho - b->lido < ((size_t)no->tam_genotipo + 31) / 32 * sizeof(uint64_t)) return 0;
+        for (int i = 0; i < no->tam_genotipo; i += 32) {
+            uint64_t palavra = buffer_ler_u64(b);
+            if (no->genes) {
+                no->genes[i >> 5] = palavra;
+            } else {
+                for (int j = 0; j < 32 && i + j < no->tam_genotipo; j++, palavra >>= 2)
+                    no->genotipo[i + j] = letra_vizinho[palavra & 3u];
+            }
         }
+    }
+    return 1;
+}
 
-        for (int i = 0; i < 50; i++) {
-            int idx = inicio2 + i;
-            filho->genotipo[50 + i] = (i < tam2_real) ? proximo->genotipo[idx] : direcoes[rand() % 4];
-        }
+Lista *restaurar_estado(const char *arquivo, const Matriz *matriz, PoolThreads *pool, Controlador *controlador,
+                        int *geracao) {
+    if (!arquivo || !matriz) return NULL;
+    BufferRede b = {0};
+    Lista *lista = NULL;
+    if (!ler_arquivo_estado(arquivo, &b)) goto fim;
+    if (b.tamanho - b.lido < BYTES_CABECALHO_ESTADO + 32 + 4) {
+        printf("Arquivo de estado %s invalido ou corrompido\n", arquivo);
+        goto fim;
+    }
+    uint64_t assinatura = buffer_ler_u64(&b);
+    uint32_t linhas = buffer_ler_u32(&b), colunas = buffer_ler_u32(&b);
+    if (assinatura != assinatura_mapa(matriz) || linhas != matriz->linhas || colunas != matriz->colunas) {
+        printf("O estado salvo em %s foi gerado com outro mapa\n", arquivo);
+        goto fim;
+    }
+    int salva = (int)buffer_ler_u32(&b);
 
-        aplicar_mutacao(filho, TAXA_MUTACAO);
+    Configuracao config = configuracao_padrao();
+    ler_configuracao(&b, &config);
+    if (config.modo_fitness != matriz->modo_fitness) {
+        printf("O estado salvo em %s usa outro modo de fitness\n", arquivo);
+        goto fim;
+    }
+    EstadoExecucao estado;
+    memset(&estado, 0, sizeof(estado));
+    int iniciado;
+    unsigned long long ns;
+    ler_controlador(&b, &config, &estado, &iniciado, &ns);
+    Gerador global;
+    ler_gerador(&b, &global);
+    uint32_t num_geradores = buffer_ler_u32(&b);
+    if (num_geradores != (uint32_t)(pool ? pool->num_threads : 0)) {
+        printf("O estado foi salvo com %u geradores de threads, mas ha %d\n", num_geradores,
+               pool ? pool->num_threads : 0);
+        goto fim;
+    }
+    if (b.tamanho - b.lido < (size_t)num_geradores * 32) goto corrompido;
+    // Os geradores do pool só são trocados depois que a população for lida
+    size_t inicio_geradores = b.lido;
+    b.lido += (size_t)num_geradores * 32;
 
-        int x = matriz->x_inicial;
-        int y = matriz->y_inicial;
-        int colisoes = 0;
-        int mov_validos = 0;
+    lista = cria_lista_configurada(&config);
+    if (!lista) goto fim;
+    if (!ler_populacao(&b, &lista->atual)) goto corrompido;
+    b.lido = inicio_geradores;
+    for (uint32_t i = 0; i < num_geradores; i++) ler_gerador(&b, &pool->geradores[i]);
+    gerador_global = global;
+    if (controlador) {
+        controlador->estado = estado;
+        controlador->iniciado = iniciado;
+        controlador->inicio_ns = agora_ns() - ns;
+    }
+    lista->telemetria.geracao = salva;
+    if (geracao) *geracao = salva;
+    goto fim;
 
-        for (int i = 0; i < 100; i++) {
-            int novo_x = x, novo_y = y;
+corrompido:
+    printf("Arquivo de estado %s invalido ou corrompido\n", arquivo);
+    liberar_lista(lista);
+    lista = NULL;
+fim:
+    free(b.dados);
+    return lista;
+}
 
-            switch (filho->genotipo[i]) {
-                case 'C': 
-                    if (x > 0) novo_x--;
-                    break;
-                case 'B': 
-                    if (x < (int)matriz->linhas - 1) novo_x++;
-                    break;
-                case 'E': 
-                    if (y > 0) novo_y--;
-                    break;
-                case 'D': 
-                    if (y < (int)matriz->colunas - 1) novo_y++;
-                    break;
-                default:
-                    break;
-            }
+/* ---- Resolução em lote ----
+ *
+ * resolver_lote() lê a lista de mapas (os arquivos de um diretório, em
+ * ordem de nome, ou as linhas de um manifesto) e distribui uma execução do
+ * algoritmo por mapa entre config->threads trabalhadores. Cada trabalhador
+ * começa com uma faixa contígua de mapas e, quando a sua acaba, rouba a
+ * metade final da maior faixa alheia; uma faixa [inicio, fim) cabe num
+ * inteiro de 64 bits e muda só por compare-and-swap, e como cada valor
+ * descreve exatamente os mapas ainda livres, um CAS atrasado que acerte um
+ * valor repetido continua correto. Lista, arenas e avaliador de cada
+ * trabalhador são reaproveitados de um mapa para o outro; o gerador de cada
+ * mapa é semeado com a semente mais o índice dele, de modo que o resultado
+ * não depende de qual thread o resolveu. */
 
-            if (novo_x < 0 || novo_x >= (int)matriz->linhas || novo_y < 0 || novo_y >= (int)matriz->colunas) {
-                colisoes++;
-                break;
-            }
+typedef struct _fila_lote {
+    _Alignas(64) atomic_ullong faixa;  /* (inicio << 32) | fim */
+} FilaLote;
 
-            if (matriz->mapa[novo_x][novo_y] == '#') {
-                colisoes++;
-                break;
-            }
+typedef struct _resultado_lote {
+    int carregado;
+    unsigned int linhas, colunas;
+    int geracoes;
+    MotivoParada motivo;
+    unsigned long long avaliacoes;
+    double segundos;
+    int resolvido;
+    float fitness;
+    int x, y;
+    int movimentos;
+    char *genotipo;
+} ResultadoLote;
 
-            x = novo_x;
-            y = novo_y;
-            mov_validos++;
+typedef struct _lote {
+    Configuracao config;
+    char **arquivos;
+    int num_arquivos;
+    ResultadoLote *resultados;
+    FilaLote *filas;
+    int num_filas;
+} Lote;
 
-            if (x == matriz->x_final && y == matriz->y_final) break;
-        }
+typedef struct _trabalhador_lote {
+    Lote *lote;
+    int indice;
+} TrabalhadorLote;
 
-        filho->x = x;
-        filho->y = y;
-        filho->colisoes = colisoes;
-        filho->tam_genotipo = mov_validos;
-        filho->totalMov = mov_validos;
-        filho->fitness = calcula_fitness(matriz, filho);
+static inline uint64_t faixa_lote(uint32_t inicio, uint32_t fim) {
+    return ((uint64_t)inicio << 32) | fim;
+}
 
-        if (nova_lista->inicio == NULL) {
-            nova_lista->inicio = filho;
-            nova_lista->fim = filho;
-        } else {
-            nova_lista->fim->proximo = filho;
-            nova_lista->fim = filho;
+/* Próximo mapa do trabalhador `indice`, roubando se preciso; -1 no fim. */
+static int proximo_mapa(Lote *lote, int indice) {
+    atomic_ullong *propria = &lote->filas[indice].faixa;
+    for (;;) {
+        uint64_t atual = atomic_load(propria);
+        uint32_t inicio = (uint32_t)(atual >> 32), fim = (uint32_t)atual;
+        if (inicio < fim) {
+            if (atomic_compare_exchange_weak(propria, &atual, faixa_lote(inicio + 1, fim))) return (int)inicio;
+            continue;
         }
 
-        atual = proximo->proximo;
-        criados++;
+        int vitima = -1;
+        uint32_t maior = 0;
+        uint64_t alheia = 0;
+        for (int i = 0; i < lote->num_filas; i++) {
+            if (i == indice) continue;
+            uint64_t f = atomic_load(&lote->filas[i].faixa);
+            uint32_t tamanho = (uint32_t)f - (uint32_t)(f >> 32);
+            if ((uint32_t)(f >> 32) < (uint32_t)f && tamanho > maior) {
+                vitima = i;
+                maior = tamanho;
+                alheia = f;
+            }
+        }
+        if (vitima < 0) return -1;
+        uint32_t de = (uint32_t)(alheia >> 32), ate = (uint32_t)alheia;
+        uint32_t meio = de + (ate - de) / 2;
+        if (!atomic_compare_exchange_strong(&lote->filas[vitima].faixa, &alheia, faixa_lote(de, meio))) continue;
+        // Só o dono grava uma faixa não vazia na própria fila
+        atomic_store(propria, faixa_lote(meio + 1, ate));
+        return (int)meio;
     }
+}
 
-    int faltam = TOTAL_INDIVIDUOS - ELITE - criados;
-    if (faltam > 0) {
-        insere_elementos(nova_lista, matriz, faltam);
+/* Reaproveita o avaliador se os buffers dele cobrem o novo mapa; senão
+ * troca por um novo. Os carimbos antigos nunca coincidem com os próximos. */
+static Avaliador *avaliador_para_mapa(Avaliador *avaliador, Matriz *matriz) {
+    if (avaliador && avaliador->capacidade_celulas >= matriz->total_celulas) {
+        avaliador->matriz = matriz;
+        return avaliador;
     }
-
-    return nova_lista;
+    liberar_avaliador(avaliador);
+    return cria_avaliador(matriz);
 }
 
-void liberar_lista(Lista *lista) {
-    if (!lista) return;
-
-    No *atual = lista->inicio;
-    while (atual) {
-        No *prox = atual->proximo;
-        if (atual->genotipo) {
-            free(atual->genotipo);
-        }
-        free(atual);
-        atual = prox;
-    }
-    free(lista);
+static char *copiar_genotipo(const No *no) {
+    char *texto = malloc((size_t)no->tam_genotipo + 1);
+    if (!texto) return NULL;
+    for (int i = 0; i < no->tam_genotipo; i++)
+        texto[i] = letra_gene(no, i);
+    texto[no->tam_genotipo] = '\0';
+    return texto;
 }
 
-void liberar_matriz(Matriz *matriz) {
+/* Uma execução completa sobre o mapa `indice`, com a lista e o avaliador
+ * do trabalhador. */
+static void resolver_mapa(Lote *lote, int indice, Lista *lista, Avaliador **avaliador) {
+    ResultadoLote *r = &lote->resultados[indice];
+    const Configuracao *config = &lote->config;
+    Matriz *matriz = carregar_mapa(lote->arquivos[indice]);
     if (!matriz) return;
+    Controlador *controlador = NULL;
+    if (!definir_modo_fitness(matriz, config->modo_fitness) || !ativar_cache_fitness(matriz, config->cache_fitness) ||
+        !(*avaliador = avaliador_para_mapa(*avaliador, matriz)) || !(controlador = cria_controlador(matriz, config)))
+        goto fim;
 
-    for (unsigned int i = 0; i < matriz->linhas; i++) {
-        free(matriz->mapa[i]);
+    Gerador gerador;
+    gerador_semear(&gerador, config->semente + (uint64_t)indice);
+    lista->config = *config;
+    lista->atual.quantidade = 0;
+    lista->reserva.quantidade = 0;
+    if (!arena_insere_elementos(&lista->atual, matriz, config->tamanho_populacao, config, &gerador, *avaliador))
+        goto fim;
+
+    int geracao = 0;
+    while (controlar_execucao(controlador, lista, geracao)) {
+        if (!avancar_lista(lista, matriz, &gerador, *avaliador)) goto fim;
+        geracao++;
     }
-    free(matriz->mapa);
-    free(matriz);
+
+    // O melhor indivíduo no objetivo, se houver; senão, o melhor de todos
+    const Arena *arena = &lista->atual;
+    const No *melhor = NULL;
+    int no_objetivo = 0;
+    for (int i = 0; i < arena->quantidade; i++) {
+        const No *no = &arena->individuos[i];
+        int chegou = no->x == matriz->x_final && no->y == matriz->y_final;
+        if (chegou && !no_objetivo) melhor = NULL;
+        if (chegou < no_objetivo) continue;
+        no_objetivo |= chegou;
+        if (!melhor || no->fitness > melhor->fitness) melhor = no;
+    }
+    const EstadoExecucao *estado = estado_execucao(controlador);
+    r->carregado = 1;
+    r->linhas = matriz->linhas;
+    r->colunas = matriz->colunas;
+    r->geracoes = geracao;
+    r->motivo = estado->motivo;
+    r->avaliacoes = estado->avaliacoes;
+    r->segundos = estado->segundos;
+    r->resolvido = no_objetivo;
+    if (melhor) {
+        r->fitness = melhor->fitness;
+        r->x = melhor->x;
+        r->y = melhor->y;
+        r->movimentos = melhor->tam_genotipo;
+        r->genotipo = copiar_genotipo(melhor);
+    }
+fim:
+    liberar_controlador(controlador);
+    // O avaliador fica com o trabalhador, mas não pode apontar para o mapa liberado
+    liberar_matriz(matriz);
 }
 
-void iterar_lista(Lista *lista, void (*callback)(No *no, void *contexto), void *contexto) {
-    if (!lista || !callback) return;
-    No *atual = get_inicio_lista(lista);  // se quiser, internamente acessa lista->inicio
-    while (atual != NULL) {
-        callback(atual, contexto);
-        atual = get_proximo_no(atual);
+static void *executar_trabalhador_lote(void *arg) {
+    TrabalhadorLote *t = arg;
+    Lista *lista = cria_lista_configurada(&t->lote->config);
+    Avaliador *avaliador = NULL;
+    if (lista) {
+        int indice;
+        while ((indice = proximo_mapa(t->lote, t->indice)) >= 0)
+            resolver_mapa(t->lote, indice, lista, &avaliador);
     }
+    liberar_avaliador(avaliador);
+    liberar_lista(lista);
+    return NULL;
 }
 
-void salvar_individuo_csv(No *no, void *contexto) {
-    FILE *arquivo = (FILE *)contexto;
-    if (!arquivo || !no) return;
+static int comparar_nomes(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
 
-    fprintf(arquivo, "\"");  // Início do campo genotipo (entre aspas)
-    for (int i = 0; i < no->tam_genotipo; i++) {
-        fputc(no->genotipo[i], arquivo);
+static int acrescentar_arquivo(Lote *lote, int *capacidade, const char *pasta, const char *nome) {
+    if (lote->num_arquivos == *capacidade) {
+        int nova = *capacidade ? *capacidade * 2 : CAPACIDADE_INICIAL;
+        char **arquivos = realloc(lote->arquivos, (size_t)nova * sizeof(char *));
+        if (!arquivos) return 0;
+        lote->arquivos = arquivos;
+        *capacidade = nova;
     }
-    fprintf(arquivo, "\",");
+    size_t tam_pasta = pasta ? strlen(pasta) : 0;
+    char *caminho = malloc(tam_pasta + 1 + strlen(nome) + 1);
+    if (!caminho) return 0;
+    if (pasta)
+        sprintf(caminho, "%s/%s", pasta, nome);
+    else
+        strcpy(caminho, nome);
+    lote->arquivos[lote->num_arquivos++] = caminho;
+    return 1;
+}
 
-    fprintf(arquivo, "%.2f,%d,%d,%d,%d\n", no->fitness, no->totalMov, no->colisoes, no->x, no->y);
+/* Diretório: seus arquivos comuns, menos os ocultos, em ordem de nome.
+ * Arquivo: um mapa por linha (linhas vazias e iniciadas por # são
+ * ignoradas), com caminhos relativos à pasta do manifesto. */
+static int listar_mapas(const char *entrada, Lote *lote) {
+    struct stat info;
+    if (stat(entrada, &info) != 0) {
+        printf("Falha ao abrir %s\n", entrada);
+        return 0;
+    }
+    int capacidade = 0;
+    if (S_ISDIR(info.st_mode)) {
+        DIR *dir = opendir(entrada);
+        if (!dir) {
+            printf("Falha ao abrir o diretorio %s\n", entrada);
+            return 0;
+        }
+        struct dirent *d;
+        int ok = 1;
+        while (ok && (d = readdir(dir)) != NULL) {
+            if (d->d_name[0] == '.') continue;
+            if (!acrescentar_arquivo(lote, &capacidade, entrada, d->d_name)) ok = 0;
+            else if (stat(lote->arquivos[lote->num_arquivos - 1], &info) != 0 || !S_ISREG(info.st_mode))
+                free(lote->arquivos[--lote->num_arquivos]);
+        }
+        closedir(dir);
+        if (!ok) return 0;
+        if (lote->num_arquivos > 1)
+            qsort(lote->arquivos, (size_t)lote->num_arquivos, sizeof(char *), comparar_nomes);
+        return 1;
+    }
+
+    FILE *manifesto = fopen(entrada, "r");
+    if (!manifesto) {
+        printf("Falha ao abrir o manifesto %s\n", entrada);
+        return 0;
+    }
+    char *pasta = NULL;
+    const char *barra = strrchr(entrada, '/');
+    if (barra && (pasta = malloc((size_t)(barra - entrada) + 1))) {
+        memcpy(pasta, entrada, (size_t)(barra - entrada));
+        pasta[barra - entrada] = '\0';
+    }
+    char *linha = NULL;
+    size_t tam_linha = 0;
+    int ok = !barra || pasta;
+    while (ok && getline(&linha, &tam_linha, manifesto) != -1) {
+        size_t n = strlen(linha);
+        while (n > 0 && (linha[n - 1] == '\n' || linha[n - 1] == '\r' || linha[n - 1] == ' ' || linha[n - 1] == '\t'))
+            linha[--n] = '\0';
+        if (n == 0 || linha[0] == '#') continue;
+        ok = acrescentar_arquivo(lote, &capacidade, linha[0] == '/' ? NULL : pasta, linha);
+    }
+    free(linha);
+    free(pasta);
+    fclose(manifesto);
+    return ok;
 }
 
-void salvar_lista_csv(Lista *lista, const char *nome_arquivo) {
-    FILE *arquivo = fopen(nome_arquivo, "w");
-    if (!arquivo) {
-        printf("Erro ao abrir o arquivo CSV para escrita.\n");
-        return;
+static int gravar_resultados_lote(const Lote *lote, const char *arquivo) {
+    FILE *saida = fopen(arquivo, "w");
+    if (!saida) {
+        printf("Falha ao abrir arquivo %s\n", arquivo);
+        return 0;
+    }
+    fprintf(saida, "mapa,linhas,colunas,resolvido,geracoes,parada,avaliacoes,segundos,fitness,x,y,movimentos,genotipo\n");
+    for (int i = 0; i < lote->num_arquivos; i++) {
+        const ResultadoLote *r = &lote->resultados[i];
+        if (!r->carregado) {
+            fprintf(saida, "%s,0,0,0,0,falha,0,0,,,,,\n", lote->arquivos[i]);
+            continue;
+        }
+        fprintf(saida, "%s,%u,%u,%d,%d,%s,%llu,%.3f,%.2f,%d,%d,%d,%s\n", lote->arquivos[i], r->linhas, r->colunas,
+                r->resolvido, r->geracoes, descrever_parada(r->motivo), r->avaliacoes, r->segundos, r->fitness,
+                r->x, r->y, r->movimentos, r->genotipo ? r->genotipo : "");
     }
+    return fclose(saida) == 0;
+}
 
-    // Cabeçalho CSV
-    fprintf(arquivo, "genotipo,fitness,totalMov,colisoes,x,y\n");
+int resolver_lote(const Configuracao *config, ResumoLote *resumo) {
+    if (!config || !config->arquivo_lote || !validar_configuracao(config)) return 0;
+    unsigned long long inicio = agora_ns();
+    Lote lote;
+    memset(&lote, 0, sizeof(lote));
+    lote.config = *config;
+    int ok = listar_mapas(config->arquivo_lote, &lote);
+    int num_threads = config->threads;
+    pthread_t *threads = NULL;
+    TrabalhadorLote *trabalhadores = NULL;
+    if (ok && lote.num_arquivos > 0) {
+        if (num_threads > lote.num_arquivos) num_threads = lote.num_arquivos;
+        lote.resultados = calloc((size_t)lote.num_arquivos, sizeof(ResultadoLote));
+        lote.filas = aligned_alloc(64, (size_t)num_threads * sizeof(FilaLote));
+        threads = malloc((size_t)num_threads * sizeof(pthread_t));
+        trabalhadores = malloc((size_t)num_threads * sizeof(TrabalhadorLote));
+        ok = lote.resultados && lote.filas && threads && trabalhadores;
+        if (!ok) printf("Erro ao alocar o lote\n");
+    }
+    if (ok && lote.num_arquivos > 0) {
+        lote.num_filas = num_threads;
+        for (int i = 0; i < num_threads; i++) {
+            uint32_t de = (uint32_t)((long long)lote.num_arquivos * i / num_threads);
+            uint32_t ate = (uint32_t)((long long)lote.num_arquivos * (i + 1) / num_threads);
+            atomic_init(&lote.filas[i].faixa, faixa_lote(de, ate));
+            trabalhadores[i].lote = &lote;
+            trabalhadores[i].indice = i;
+        }
+        // A thread chamadora é o trabalhador 0; sem threads extras, ela rouba o resto sozinha
+        int criadas = 1;
+        for (; criadas < num_threads; criadas++)
+            if (pthread_create(&threads[criadas], NULL, executar_trabalhador_lote, &trabalhadores[criadas]) != 0) {
+                printf("Erro ao criar thread %d\n", criadas);
+                break;
+            }
+        executar_trabalhador_lote(&trabalhadores[0]);
+        for (int i = 1; i < criadas; i++)
+            pthread_join(threads[i], NULL);
+        ok = gravar_resultados_lote(&lote, config->arquivo_saida);
+    }
 
-    // Itera sobre a lista e grava cada indivíduo
-    iterar_lista(lista, salvar_individuo_csv, arquivo);
+    ResumoLote r;
+    memset(&r, 0, sizeof(r));
+    r.mapas = lote.num_arquivos;
+    for (int i = 0; lote.resultados && i < lote.num_arquivos; i++) {
+        const ResultadoLote *resultado = &lote.resultados[i];
+        r.resolvidos += resultado->resolvido;
+        r.falhas += !resultado->carregado;
+        r.avaliacoes += resultado->avaliacoes;
+        free(resultado->genotipo);
+    }
+    r.segundos = (double)(agora_ns() - inicio) / 1e9;
+    if (resumo) *resumo = r;
+    if (ok && config->arquivo_resumo) {
+        FILE *arquivo = fopen(config->arquivo_resumo, "w");
+        ok = arquivo != NULL;
+        if (ok) {
+            fprintf(arquivo, "mapas,resolvidos,falhas,avaliacoes,segundos,threads,resolvidos_por_hora\n");
+            fprintf(arquivo, "%d,%d,%d,%llu,%.3f,%d,%.1f\n", r.mapas, r.resolvidos, r.falhas, r.avaliacoes,
+                    r.segundos, config->threads, r.segundos > 0.0 ? r.resolvidos * 3600.0 / r.segundos : 0.0);
+            ok = fclose(arquivo) == 0;
+        } else {
+            printf("Falha ao abrir arquivo %s\n", config->arquivo_resumo);
+        }
+    }
 
-    fclose(arquivo);
+    for (int i = 0; i < lote.num_arquivos; i++)
+        free(lote.arquivos[i]);
+    free(lote.arquivos);
+    free(lote.resultados);
+    free(lote.filas);
+    free(threads);
+    free(trabalhadores);
+    return ok;
 }
 
 No* get_proximo_no(No *no) {
@@ -586,8 +5255,8 @@ No* get_proximo_no(No *no) {
 }
 
 No* get_inicio_lista(Lista *lista) {
-    if (!lista) return NULL;
-    return lista->inicio;
+    if (!lista || lista->atual.quantidade == 0) return NULL;
+    return lista->atual.individuos;
 }
 
 
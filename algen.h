@@ -7,6 +7,179 @@ typedef struct _no No;
 typedef struct _lista Lista;
 typedef struct _posicao Posicao;
 typedef struct _matriz Matriz;
+typedef struct _avaliador Avaliador;
+typedef struct _pool_threads PoolThreads;
+typedef struct _arquipelago Arquipelago;
+typedef struct _distribuidor Distribuidor;
+typedef struct _gravador Gravador;
+typedef struct _salvamento Salvamento;
+typedef struct _controlador Controlador;
+
+/**
+ * @brief Como o fitness mede a distância da posição final ao objetivo.
+ */
+typedef enum {
+    FITNESS_MANHATTAN,  /**< Distância de Manhattan, ignorando as paredes. */
+    FITNESS_CAMINHO     /**< Menor caminho pelo labirinto (campo de distâncias por BFS). */
+} ModoFitness;
+
+/**
+ * @brief Como os pais de cada filho são escolhidos na população atual.
+ *
+ * Fora SELECAO_VIZINHOS, nenhum operador precisa da população ordenada
+ * (só a elite é separada) e cada escolha é feita pela thread que monta o
+ * filho, com o gerador dela.
+ */
+typedef enum {
+    SELECAO_VIZINHOS,    /**< Pares vizinhos na ordem de fitness (1º com 2º, 3º com 4º...). */
+    SELECAO_TORNEIO,     /**< Melhor de k sorteados; O(k) por escolha. */
+    SELECAO_AMOSTRAGEM,  /**< Amostragem universal estocástica proporcional ao fitness; O(log n) por escolha. */
+    SELECAO_RANKING      /**< Roleta por ranking linear, sem ordenar; O(1) por escolha. */
+} ModoSelecao;
+
+/**
+ * @brief Como o genótipo do filho é montado a partir dos dois pais.
+ *
+ * Fora CROSSOVER_METADES, o filho tem o tamanho que resulta dos cortes nos
+ * pais (até o maior genótipo da população), sem movimentos sorteados.
+ */
+typedef enum {
+    CROSSOVER_METADES,     /**< tam_filho/2 iniciais do primeiro pai e tam_filho/2 finais do segundo, completados ao acaso. */
+    CROSSOVER_UM_PONTO,    /**< Início do primeiro pai até um corte e fim do segundo a partir de outro. */
+    CROSSOVER_DOIS_PONTOS, /**< Primeiro pai com um trecho do meio trocado por um trecho do segundo. */
+    CROSSOVER_POSICIONAL   /**< Une os pais numa célula visitada pelos dois caminhos. */
+} ModoCrossover;
+
+/**
+ * @brief Parâmetros do algoritmo genético e da execução.
+ *
+ * Obtenha os valores padrão com configuracao_padrao() e altere apenas os
+ * campos desejados.
+ */
+typedef struct _configuracao {
+    int tamanho_populacao;     /**< Indivíduos por geração. */
+    int elite;                 /**< Melhores copiados sem alteração. */
+    int max_filhos;            /**< Máximo de filhos gerados por crossover. */
+    float taxa_mutacao;        /**< Probabilidade de mutação por movimento (0 a 1). */
+    int tam_filho;             /**< Comprimento do genótipo dos filhos. */
+    int passeio_min;           /**< Menor comprimento do passeio aleatório. */
+    int passeio_max;           /**< Maior comprimento do passeio aleatório. */
+    int genoma_compacto;       /**< Diferente de 0 para guardar 2 bits por movimento. */
+    ModoFitness modo_fitness;  /**< Medida de distância usada no fitness. */
+    ModoSelecao selecao;       /**< Operador de seleção dos pais. */
+    int tamanho_torneio;       /**< Sorteados em cada torneio (SELECAO_TORNEIO). */
+    float pressao_ranking;     /**< Cópias esperadas do melhor, de 1 a 2 (SELECAO_RANKING). */
+    ModoCrossover crossover;   /**< Operador de crossover. */
+    int lote_estacionario;     /**< Filhos por lote no modo estacionário; 0 usa gerações completas. Sem avaliação distribuída. */
+    int cache_fitness;         /**< Entradas do cache de fitness dos filhos; 0 desliga. */
+    int geracoes;              /**< Número de gerações da execução. */
+    int threads;               /**< Threads usadas na construção das gerações. */
+    unsigned long long semente; /**< Semente do gerador; 0 usa o relógio. */
+    const char *arquivo_mapa;  /**< Caminho do arquivo do mapa. */
+    const char *arquivo_saida; /**< Caminho do CSV de saída. */
+    const char *arquivo_telemetria; /**< Telemetria por geração; NULL desliga. */
+    int telemetria_json;       /**< Diferente de 0 para linhas JSON em vez de CSV. */
+    int ilhas;                 /**< Populações independentes no modo arquipélago. */
+    int intervalo_migracao;    /**< Gerações entre migrações; 0 desliga a migração. */
+    int migrantes;             /**< Melhores enviados à ilha vizinha a cada migração. */
+    const char *trabalhadores; /**< Endereços de trabalhadores remotos (vírgulas); NULL desliga. */
+    int trabalhadores_locais;  /**< Trabalhadores locais criados com fork(); 0 desliga. */
+    const char *endereco_servico; /**< Se definido, o processo atende como trabalhador. */
+    const char *arquivo_binario; /**< Se definido, converte o mapa para o formato binário e sai. */
+    int binario_sem_metadados; /**< Diferente de 0 para gravar só o bitset, sem vizinhança e distâncias. */
+    const char *arquivo_populacoes; /**< Grava a população de cada geração; NULL desliga. */
+    int populacoes_binario;    /**< Diferente de 0 para o formato binário em vez de CSV. */
+    int comprimir_populacoes;  /**< Diferente de 0 para comprimir o arquivo em blocos. */
+    int fila_populacoes;       /**< Gerações que a fila do gravador guarda enquanto a escrita não as alcança. */
+    int descartar_populacoes;  /**< Diferente de 0 para descartar gerações com a fila cheia em vez de esperar. */
+    const char *arquivo_descomprimir; /**< Se definido, expande esse arquivo comprimido em arquivo_saida e sai. */
+    const char *arquivo_estado; /**< Salva o estado completo da execução; NULL desliga. */
+    int intervalo_estado;      /**< Segundos entre salvamentos do estado; 0 salva a cada geração. */
+    const char *arquivo_retomada; /**< Se definido, retoma a execução a partir desse estado. */
+    int parar_no_objetivo;     /**< Diferente de 0 para encerrar quando algum indivíduo chega ao objetivo. */
+    int geracoes_sem_melhora;  /**< Encerra após tantas gerações sem melhorar o melhor fitness; 0 desliga. */
+    double tempo_limite;       /**< Segundos de execução antes de encerrar; 0 desliga. */
+    unsigned long long max_avaliacoes; /**< Indivíduos avaliados antes de encerrar; 0 desliga. */
+    int mutacao_adaptativa;    /**< Diferente de 0 para reduzir a mutação enquanto o melhor não melhora. */
+    int populacao_minima;      /**< Reduz a população linearmente até esse tamanho na última geração; 0 desliga. */
+    const char *arquivo_lote;  /**< Diretório ou manifesto de mapas resolvidos por resolver_lote(); NULL desliga. */
+    const char *arquivo_resumo; /**< CSV com o resumo do lote; NULL desliga. */
+} Configuracao;
+
+/**
+ * @brief Seções opcionais do formato binário de mapa.
+ */
+typedef enum {
+    MAPA_VIZINHANCA = 1,  /**< Tabela de vizinhança pré-calculada. */
+    MAPA_DISTANCIA = 2    /**< Distância (em passos) de cada célula ao objetivo. */
+} SecaoMapa;
+
+/**
+ * @brief Formato do arquivo de populações gravado por um Gravador.
+ */
+typedef enum {
+    SAIDA_CSV,      /**< Uma linha por indivíduo, com a coluna da geração. */
+    SAIDA_BINARIA   /**< Genótipos com 2 bits por movimento e métricas de largura fixa. */
+} FormatoSaida;
+
+/**
+ * @brief Etapas cronometradas pela telemetria de cada geração.
+ */
+typedef enum {
+    TELEMETRIA_ORDENACAO,
+    TELEMETRIA_ELITISMO,
+    TELEMETRIA_CROSSOVER,
+    TELEMETRIA_MUTACAO,
+    TELEMETRIA_AVALIACAO,
+    TELEMETRIA_REPOSICAO,
+    TELEMETRIA_TOTAL_ETAPAS
+} EtapaTelemetria;
+
+/**
+ * @brief Medições de uma geração, entregues ao sink de telemetria.
+ *
+ * Com nova_geracao_paralela() os tempos das etapas são somados entre as
+ * threads, e podem passar de `ns_total`.
+ */
+typedef struct _estatisticas_geracao {
+    int geracao;                                  /**< Número da geração (a partir de 1). */
+    unsigned long long ns[TELEMETRIA_TOTAL_ETAPAS]; /**< Tempo de cada etapa, em nanossegundos. */
+    unsigned long long ns_total;                  /**< Tempo total da geração. */
+    unsigned long long alocacoes;                 /**< Blocos alocados pela lista na geração. */
+    unsigned long long bytes_alocados;            /**< Bytes desses blocos. */
+    int populacao;                                /**< Indivíduos da nova geração. */
+    float melhor_fitness;
+    float media_fitness;
+    float pior_fitness;
+    float diversidade;                            /**< Fração de genótipos distintos. */
+    float taxa_objetivo;                          /**< Fração que termina no objetivo. */
+    float taxa_cache;                             /**< Fração dos filhos achados no cache de fitness. */
+} EstatisticasGeracao;
+
+/**
+ * @brief Destino das medições: chamado ao fim de cada geração.
+ */
+typedef void (*SinkTelemetria)(const EstatisticasGeracao *estatisticas, void *contexto);
+
+/**
+ * @brief Retorna a configuração padrão (100 indivíduos, elite 5, 45 filhos,
+ * mutação 0.05, filhos de 100 movimentos, passeios de 10 a 100, 50 gerações).
+ * @return Configuração com os valores padrão.
+ */
+Configuracao configuracao_padrao(void);
+
+/**
+ * @brief Verifica se os parâmetros de uma configuração são coerentes.
+ * @param config Ponteiro para a configuração.
+ * @return 1 se a configuração é válida, 0 caso contrário (com mensagem).
+ */
+int validar_configuracao(const Configuracao *config);
+
+/**
+ * @brief Define a semente do gerador pseudoaleatório usado pelas funções seriais.
+ * @param semente Semente do gerador (xoshiro256**).
+ */
+void semear_aleatorio(unsigned long long semente);
 
 /**
  * @brief Cria um novo indivíduo com genótipo aleatório baseado no mapa.
@@ -15,6 +188,12 @@ typedef struct _matriz Matriz;
  */
 No *cria_no(Matriz *matriz);
 
+/**
+ * @brief Libera um indivíduo avulso criado por cria_no().
+ * @param no Ponteiro para o indivíduo a ser liberado.
+ */
+void liberar_no(No *no);
+
 /**
  * @brief Obtém os vizinhos válidos para movimentação em uma posição do mapa.
  * @param matriz Ponteiro para a estrutura Matriz.
@@ -37,17 +216,153 @@ Posicao proximo_estado_markov(Matriz *matriz, int x_atual, int y_atual);
 
 /**
  * @brief Gera o genótipo do indivíduo baseado em um passeio aleatório pelo mapa.
+ *
+ * O genótipo é escrito no buffer já reservado do indivíduo (fatia da arena da
+ * lista ou buffer de cria_no()), sem alocar memória.
  * @param matriz Ponteiro para a estrutura Matriz.
  * @param no Ponteiro para o indivíduo onde o genótipo será armazenado.
  */
 void cria_genotipo(Matriz *matriz, No *no);
 
 /**
- * @brief Carrega o mapa a partir de um arquivo texto.
+ * @brief Carrega o mapa a partir de um arquivo texto ou binário.
+ *
+ * O arquivo é mapeado na memória com mmap() e percorrido uma única vez,
+ * indexando o início de cada linha (LF ou CRLF), montando o bitset de
+ * células transitáveis e localizando S e E; não há limite de largura. Os
+ * caracteres não são copiados: a matriz usa os bytes mapeados até
+ * compactar_mapa(). Sair do mapa conta como colisão, e a tabela de
+ * vizinhança é montada a partir do bitset.
+ *
+ * Arquivos gravados por salvar_mapa_binario() são reconhecidos pela
+ * assinatura e usados no lugar, sem análise: o bitset e as seções
+ * pré-calculadas apontam para os bytes mapeados.
  * @param arquivo Nome do arquivo contendo o mapa.
  * @return Ponteiro para a matriz carregada, ou NULL em caso de erro.
  */
-Matriz *carregar_mapa(char *arquivo);
+Matriz *carregar_mapa(const char *arquivo);
+
+/**
+ * @brief Cria um mapa a partir de caracteres já em memória.
+ *
+ * Usa os mesmos símbolos do arquivo (S, E, # e .), sem quebras de linha.
+ * @param linhas Número de linhas do mapa.
+ * @param colunas Número de colunas do mapa.
+ * @param celulas Buffer com linhas * colunas caracteres, linha após linha.
+ * @return Ponteiro para a matriz criada, ou NULL em caso de erro.
+ */
+Matriz *criar_mapa(unsigned int linhas, unsigned int colunas, const char *celulas);
+
+/**
+ * @brief Descarta os caracteres do mapa, mantendo apenas o bitset e a tabela de vizinhança.
+ *
+ * Desfaz o mapeamento do arquivo texto; em mapas binários não há o que
+ * descartar. Útil para mapas muito grandes: a evolução
+ * continua funcionando, pois os percursos consultam somente o bitset e a
+ * tabela.
+ * @param matriz Ponteiro para a matriz a ser compactada.
+ */
+void compactar_mapa(Matriz *matriz);
+
+/**
+ * @brief Grava o mapa no formato binário lido por carregar_mapa().
+ *
+ * O arquivo contém um cabeçalho, o bitset de células livres, as posições
+ * de S e E e, opcionalmente, a tabela de vizinhança e o campo de distâncias
+ * (calculado aqui se ainda não existir). Os inteiros ficam na ordem de bytes
+ * da máquina, e a leitura rejeita arquivos de outra arquitetura.
+ * @param matriz Ponteiro para a matriz.
+ * @param arquivo Caminho do arquivo de saída.
+ * @param secoes Combinação de SecaoMapa a incluir (0 para só o bitset).
+ * @return 1 em caso de sucesso, 0 em erro.
+ */
+int salvar_mapa_binario(Matriz *matriz, const char *arquivo, int secoes);
+
+/**
+ * @brief Calcula, por busca em largura a partir de E, a distância de cada célula ao objetivo.
+ *
+ * Não faz nada se o campo já existir (por exemplo, lido de um mapa binário).
+ * @param matriz Ponteiro para a matriz.
+ * @return 1 em caso de sucesso, 0 em erro de alocação.
+ */
+int calcular_distancias(Matriz *matriz);
+
+/**
+ * @brief Retorna a menor quantidade de passos de uma célula até o objetivo.
+ * @param matriz Ponteiro para a matriz, com o campo de distâncias calculado.
+ * @param x Linha da célula.
+ * @param y Coluna da célula.
+ * @return A distância, ou -1 se a célula for parede, inalcançável, estiver
+ * fora do mapa ou se as distâncias não tiverem sido calculadas.
+ */
+int distancia_objetivo(const Matriz *matriz, int x, int y);
+
+/**
+ * @brief Escolhe a medida de distância ao objetivo usada no fitness do mapa.
+ *
+ * Com FITNESS_CAMINHO, calcula o campo de distâncias (uma vez por mapa, se
+ * ainda não existir) e cada avaliação passa a consultar a distância real
+ * pelo labirinto na posição final, em O(1). Posições sem caminho até E
+ * pontuam abaixo de todas as alcançáveis. Vale para todas as avaliações
+ * do mapa, inclusive em threads, ilhas e trabalhadores.
+ * @param matriz Ponteiro para a matriz.
+ * @param modo FITNESS_MANHATTAN ou FITNESS_CAMINHO.
+ * @return 1 em caso de sucesso, 0 em modo inválido ou erro de alocação.
+ */
+int definir_modo_fitness(Matriz *matriz, ModoFitness modo);
+
+/**
+ * @brief Retorna a medida de distância usada no fitness do mapa.
+ */
+ModoFitness modo_fitness(const Matriz *matriz);
+
+/**
+ * @brief Contadores do cache de fitness de um mapa.
+ */
+typedef struct _estatisticas_cache {
+    unsigned long long consultas;  /**< Filhos procurados no cache. */
+    unsigned long long acertos;    /**< Filhos cujo resultado veio do cache. */
+    unsigned long long insercoes;  /**< Resultados calculados e guardados. */
+    size_t capacidade;             /**< Entradas da tabela. */
+} EstatisticasCache;
+
+/**
+ * @brief Liga (ou desliga) o cache de fitness do mapa.
+ *
+ * Antes de percorrer um filho, a avaliação procura o hash de 64 bits do seu
+ * genótipo numa tabela de endereçamento aberto de tamanho fixo; se o mesmo
+ * genótipo já foi avaliado, o fitness, o corte, as colisões e a posição
+ * final são copiados sem refazer o caminho. Quando a população converge,
+ * a maior parte dos filhos repete genótipos de gerações anteriores. A
+ * tabela é compartilhada sem travas pelas threads, ilhas e pelo distribuidor
+ * que avaliam o mapa; ao encher, entradas antigas são substituídas. O
+ * resultado da execução não muda, exceto em uma colisão de hash de 64 bits.
+ * Não deve ser chamada com avaliações em andamento.
+ * @param matriz Ponteiro para a matriz.
+ * @param entradas Tamanho da tabela (arredondado para potência de 2); 0 desliga.
+ * @return 1 em caso de sucesso, 0 em parâmetro inválido ou erro de alocação.
+ */
+int ativar_cache_fitness(Matriz *matriz, int entradas);
+
+/**
+ * @brief Lê os contadores acumulados do cache de fitness do mapa.
+ * @param matriz Ponteiro para a matriz.
+ * @param estatisticas Recebe os contadores.
+ * @return 1 em caso de sucesso, 0 se o cache estiver desligado.
+ */
+int estatisticas_cache_fitness(const Matriz *matriz, EstatisticasCache *estatisticas);
+
+/**
+ * @brief Retorna o caractere de uma célula do mapa.
+ *
+ * Lê direto dos bytes do arquivo; após compactar_mapa() ou em mapas de
+ * criar_mapa(), reconstrói a célula a partir do bitset ('#', ' ', 'S' ou 'E').
+ * @param matriz Ponteiro para a matriz.
+ * @param x Linha da célula.
+ * @param y Coluna da célula.
+ * @return O caractere da célula; '#' fora do mapa.
+ */
+char celula_mapa(const Matriz *matriz, int x, int y);
 
 /**
  * @brief Imprime os indivíduos de uma lista na saída padrão.
@@ -57,10 +372,68 @@ void imprimir(Lista *lista);
 
 /**
  * @brief Cria uma lista vazia.
+ *
+ * A população é guardada em arenas contíguas (indivíduos e genótipos) que
+ * crescem sob demanda e são reaproveitadas entre as gerações.
  * @return Ponteiro para a nova lista, ou NULL em caso de erro.
  */
 Lista *cria_lista(void);
 
+/**
+ * @brief Cria uma lista vazia cujos genótipos são guardados com 2 bits por movimento.
+ *
+ * Crossover, mutação, cópia e decodificação passam a operar sobre palavras de
+ * 64 bits (32 movimentos cada); a saída (imprimir(), CSV) continua em letras.
+ * @return Ponteiro para a nova lista, ou NULL em caso de erro.
+ */
+Lista *cria_lista_compacta(void);
+
+/**
+ * @brief Cria uma lista vazia que segue os parâmetros de uma configuração.
+ *
+ * A configuração é copiada para a lista e usada por insere_elementos(),
+ * nova_geracao() e criar_lista_com_crossover().
+ * @param config Ponteiro para a configuração (validada com validar_configuracao()).
+ * @return Ponteiro para a nova lista, ou NULL em caso de erro.
+ */
+Lista *cria_lista_configurada(const Configuracao *config);
+
+/**
+ * @brief Liga a telemetria de nova_geracao() e nova_geracao_paralela() na lista.
+ *
+ * Desligada (sink NULL, o padrão), a geração não consulta o relógio nem
+ * calcula estatísticas.
+ * @param lista Ponteiro para a lista.
+ * @param sink Função chamada ao fim de cada geração, ou NULL para desligar.
+ * @param contexto Ponteiro repassado ao sink.
+ */
+void definir_telemetria(Lista *lista, SinkTelemetria sink, void *contexto);
+
+/**
+ * @brief Retorna o nome de uma etapa da telemetria (ex.: "ordenacao").
+ */
+const char *nome_etapa_telemetria(EtapaTelemetria etapa);
+
+/**
+ * @brief Escreve o cabeçalho das colunas usadas por escrever_telemetria_csv().
+ * @param arquivo Arquivo aberto para escrita.
+ */
+void escrever_cabecalho_telemetria_csv(FILE *arquivo);
+
+/**
+ * @brief Sink que escreve uma linha CSV por geração.
+ * @param estatisticas Medições da geração.
+ * @param arquivo FILE* aberto para escrita.
+ */
+void escrever_telemetria_csv(const EstatisticasGeracao *estatisticas, void *arquivo);
+
+/**
+ * @brief Sink que escreve um objeto JSON por linha a cada geração.
+ * @param estatisticas Medições da geração.
+ * @param arquivo FILE* aberto para escrita.
+ */
+void escrever_telemetria_json(const EstatisticasGeracao *estatisticas, void *arquivo);
+
 /**
  * @brief Insere um número especificado de indivíduos na lista com base no mapa.
  * @param lista Ponteiro para a lista onde os indivíduos serão inseridos.
@@ -71,12 +444,52 @@ void insere_elementos(Lista *lista, Matriz *matriz, int num_elementos);
 
 /**
  * @brief Calcula o fitness de um indivíduo com base no mapa e seu genótipo.
+ *
+ * Usa o avaliador da própria matriz (criado na primeira chamada), portanto
+ * não deve ser chamada em paralelo sobre a mesma matriz.
  * @param matriz Ponteiro para a matriz do mapa.
  * @param no Ponteiro para o indivíduo cujo fitness será calculado.
  * @return Valor do fitness calculado.
  */
 float calcula_fitness(Matriz *matriz, No *no);
 
+/**
+ * @brief Cria um contexto de avaliação reutilizável para um mapa.
+ *
+ * O avaliador mantém um buffer plano de visitas do tamanho do mapa, alocado
+ * uma única vez; cada avaliação custa proporcional ao tamanho do genótipo.
+ * @param matriz Ponteiro para a matriz do mapa.
+ * @return Ponteiro para o avaliador criado, ou NULL em caso de erro.
+ */
+Avaliador *cria_avaliador(Matriz *matriz);
+
+/**
+ * @brief Calcula o fitness de um indivíduo usando um avaliador (mesmo valor de calcula_fitness()).
+ * @param avaliador Ponteiro para o avaliador.
+ * @param no Ponteiro para o indivíduo cujo fitness será calculado.
+ * @return Valor do fitness calculado.
+ */
+float avaliar_individuo(Avaliador *avaliador, No *no);
+
+/**
+ * @brief Avalia um bloco de indivíduos percorrendo seus caminhos lado a lado.
+ *
+ * Os indivíduos são processados em grupos de 8 pistas: os passos dos genótipos
+ * são transpostos e as posições avançam juntas (AVX2 quando compilado com
+ * -mavx2, laço escalar caso contrário). Grava em cada indivíduo o fitness
+ * (mesmo valor de avaliar_individuo()), a posição final e as colisões.
+ * @param avaliador Ponteiro para o avaliador.
+ * @param individuos Vetor de ponteiros para os indivíduos.
+ * @param n Número de indivíduos no vetor.
+ */
+void avaliar_lote(Avaliador *avaliador, No **individuos, int n);
+
+/**
+ * @brief Libera a memória ocupada por um avaliador.
+ * @param avaliador Ponteiro para o avaliador a ser liberado.
+ */
+void liberar_avaliador(Avaliador *avaliador);
+
 /**
  * @brief Aplica mutação no genótipo de um indivíduo com uma taxa dada.
  * @param individuo Ponteiro para o indivíduo a sofrer mutação.
@@ -94,12 +507,28 @@ void aplicar_elitismo(Lista *origem, Lista *destino, int n);
 
 /**
  * @brief Ordena a lista de indivíduos em ordem decrescente de fitness.
+ *
+ * Usa radix sort sobre chaves inteiras derivadas do fitness (O(n)); a ordem
+ * entre indivíduos de mesmo fitness é preservada.
  * @param lista Ponteiro para a lista a ser ordenada.
  */
 void ordenar_por_fitness(Lista *lista);
 
+/**
+ * @brief Coloca os k melhores indivíduos no início da lista, em ordem decrescente de fitness.
+ *
+ * Os demais ficam depois deles, em ordem não especificada. Quando k é pequeno
+ * em relação à população usa seleção por heap (O(n log k)).
+ * @param lista Ponteiro para a lista a ser ordenada.
+ * @param k Número de melhores indivíduos a ordenar.
+ */
+void ordenar_parcial_por_fitness(Lista *lista, int k);
+
 /**
  * @brief Cria uma nova lista de indivíduos a partir da atual usando crossover e mutação.
+ *
+ * Os pais são escolhidos pelo operador de config.selecao; com
+ * SELECAO_VIZINHOS, a lista precisa estar ordenada por fitness.
  * @param lista Ponteiro para a lista da geração atual.
  * @param matriz Ponteiro para a matriz do mapa.
  * @return Ponteiro para a nova lista (nova geração), ou NULL em caso de erro.
@@ -108,14 +537,264 @@ Lista* criar_lista_com_crossover(Lista* lista, Matriz* matriz);
 
 /**
  * @brief Gera uma nova geração a partir da geração atual (seleção, crossover, mutação).
+ *
+ * A nova geração é montada na arena reserva da própria lista, que depois é
+ * trocada com a arena atual; nenhuma memória é alocada quando a população
+ * já atingiu seu tamanho estável. A lista retornada é a mesma recebida.
+ *
+ * Com config.lote_estacionario > 0 (modo estacionário), a chamada monta
+ * tamanho_populacao - elite filhos em lotes desse tamanho, e cada filho
+ * substitui no lugar o pior indivíduo, se for melhor que ele; a reserva
+ * guarda só um lote e a população nunca é copiada inteira. Pares vizinhos
+ * e a amostragem universal dão lugar ao torneio nesse modo.
  * @param geracao_atual Ponteiro para a lista da geração atual.
  * @param matriz Ponteiro para a matriz do mapa.
- * @return Ponteiro para a nova geração.
+ * @return Ponteiro para a nova geração, ou NULL em caso de erro (a geração atual é preservada).
  */
 Lista* nova_geracao(Lista *geracao_atual, Matriz *matriz);
 
 /**
- * @brief Libera a memória ocupada por uma lista de indivíduos, incluindo seus genótipos.
+ * @brief Cria um pool de threads para gerar populações em paralelo sobre um mapa.
+ *
+ * Cada thread recebe um gerador pseudoaleatório próprio, derivado da semente,
+ * e um avaliador próprio; a thread chamadora participa como a thread 0.
+ * @param matriz Ponteiro para a matriz do mapa.
+ * @param num_threads Número de threads (incluindo a chamadora), maior que zero.
+ * @param semente Semente a partir da qual os geradores das threads são derivados.
+ * @return Ponteiro para o pool criado, ou NULL em caso de erro.
+ */
+PoolThreads *cria_pool_threads(Matriz *matriz, int num_threads, unsigned long long semente);
+
+/**
+ * @brief Gera uma nova geração construindo, mutando e avaliando os filhos em paralelo.
+ *
+ * Cada thread processa um bloco fixo de indivíduos com seu próprio gerador,
+ * de modo que o resultado é idêntico para a mesma semente e o mesmo número
+ * de threads. A arena é trocada como em nova_geracao(); no modo
+ * estacionário, as threads dividem cada lote de filhos e a substituição
+ * dos piores é feita pela thread chamadora entre os lotes.
+ * @param geracao_atual Ponteiro para a lista da geração atual.
+ * @param pool Pool de threads criado para o mesmo mapa.
+ * @return Ponteiro para a nova geração, ou NULL em caso de erro.
+ */
+Lista *nova_geracao_paralela(Lista *geracao_atual, PoolThreads *pool);
+
+/**
+ * @brief Encerra as threads e libera a memória ocupada por um pool.
+ * @param pool Ponteiro para o pool a ser liberado.
+ */
+void liberar_pool_threads(PoolThreads *pool);
+
+/**
+ * @brief Cria um arquipélago de config->ilhas populações independentes.
+ *
+ * Cada ilha tem sua própria lista de config->tamanho_populacao indivíduos,
+ * thread, gerador e avaliador, e compartilha o mapa apenas para leitura.
+ * As ilhas formam um anel: a cada config->intervalo_migracao gerações, cada
+ * uma envia seus config->migrantes melhores à seguinte por uma fila sem
+ * travas e recebe os que chegaram da anterior no lugar dos seus últimos
+ * indivíduos. As populações iniciais são criadas aqui, a partir de
+ * config->semente.
+ * @param matriz Ponteiro para a matriz do mapa.
+ * @param config Ponteiro para a configuração.
+ * @return Ponteiro para o arquipélago, ou NULL em caso de erro.
+ */
+Arquipelago *cria_arquipelago(Matriz *matriz, const Configuracao *config);
+
+/**
+ * @brief Evolui todas as ilhas em paralelo pelo número de gerações pedido.
+ *
+ * As ilhas só se comunicam nas migrações; como elas não esperam umas pelas
+ * outras, quais migrantes chegam a tempo depende do escalonamento, e o
+ * resultado não é reproduzível mesmo com a semente fixa.
+ * @param arquipelago Ponteiro para o arquipélago.
+ * @param geracoes Número de gerações.
+ * @return 1 em caso de sucesso, 0 se alguma ilha falhou.
+ */
+int evoluir_arquipelago(Arquipelago *arquipelago, int geracoes);
+
+/**
+ * @brief Retorna o número de ilhas do arquipélago.
+ */
+int numero_ilhas(const Arquipelago *arquipelago);
+
+/**
+ * @brief Retorna a população de uma ilha, que continua pertencendo ao arquipélago.
+ * @param arquipelago Ponteiro para o arquipélago.
+ * @param indice Índice da ilha (0 a numero_ilhas() - 1).
+ * @return Ponteiro para a lista da ilha, ou NULL se o índice for inválido.
+ */
+Lista *obter_ilha(Arquipelago *arquipelago, int indice);
+
+/**
+ * @brief Libera o arquipélago, suas ilhas e suas threads.
+ * @param arquipelago Ponteiro para o arquipélago.
+ */
+void liberar_arquipelago(Arquipelago *arquipelago);
+
+/**
+ * @brief Por que o controlador encerrou (ou não) a execução.
+ */
+typedef enum {
+    PARADA_NENHUMA,     /**< A execução continua. */
+    PARADA_GERACOES,    /**< Chegou ao número de gerações da configuração. */
+    PARADA_OBJETIVO,    /**< Algum indivíduo termina no objetivo. */
+    PARADA_ESTAGNACAO,  /**< O melhor fitness não melhorou por config->geracoes_sem_melhora gerações. */
+    PARADA_TEMPO,       /**< Passou de config->tempo_limite segundos. */
+    PARADA_AVALIACOES,  /**< Passou de config->max_avaliacoes indivíduos avaliados. */
+    PARADA_EXTERNA      /**< O critério de definir_criterio_parada() pediu a parada. */
+} MotivoParada;
+
+/**
+ * @brief Situação da execução vista pelo controlador após cada geração.
+ */
+typedef struct _estado_execucao {
+    int geracao;                    /**< Gerações concluídas. */
+    float melhor_fitness;           /**< Melhor fitness já visto. */
+    int geracoes_sem_melhora;       /**< Gerações seguidas sem superar melhor_fitness. */
+    int no_objetivo;                /**< Indivíduos da geração que terminam no objetivo. */
+    double segundos;                /**< Tempo desde cria_controlador(). */
+    unsigned long long avaliacoes;  /**< Indivíduos avaliados (a elite copiada não conta). */
+    float taxa_mutacao;             /**< Taxa usada na próxima geração. */
+    int tamanho_populacao;          /**< Tamanho da próxima geração (por ilha). */
+    MotivoParada motivo;            /**< PARADA_NENHUMA enquanto a execução continua. */
+} EstadoExecucao;
+
+/**
+ * @brief Critério de parada extra: retorna diferente de 0 para encerrar.
+ */
+typedef int (*CriterioParada)(const EstadoExecucao *estado, void *contexto);
+
+/**
+ * @brief Cria um controlador de execução com os critérios e cronogramas da configuração.
+ *
+ * O controlador acompanha a evolução de fora: depois de cada geração,
+ * controlar_execucao() (ou controlar_arquipelago()) atualiza o estado,
+ * testa os critérios de parada (número de gerações, objetivo alcançado,
+ * estagnação, tempo e avaliações) e aplica os cronogramas às listas: com
+ * config->mutacao_adaptativa, a taxa de mutação cai 20% a cada geração sem
+ * melhora (até um quarto da configurada) e volta à configurada quando o
+ * melhor fitness melhora; com config->populacao_minima,
+ * o tamanho da população cai linearmente até ele na geração config->geracoes.
+ * Sem critérios nem cronogramas, a execução é a mesma de um laço de
+ * config->geracoes gerações.
+ * @param matriz Ponteiro para a matriz, usada para reconhecer o objetivo.
+ * @param config Ponteiro para a configuração.
+ * @return Ponteiro para o controlador, ou NULL em caso de erro.
+ */
+Controlador *cria_controlador(const Matriz *matriz, const Configuracao *config);
+
+/**
+ * @brief Acrescenta um critério de parada definido pelo usuário, testado depois dos demais.
+ * @param controlador Ponteiro para o controlador.
+ * @param criterio Função chamada após cada geração; NULL remove o critério.
+ * @param contexto Repassado ao critério.
+ */
+void definir_criterio_parada(Controlador *controlador, CriterioParada criterio, void *contexto);
+
+/**
+ * @brief Registra a geração concluída de uma lista e decide se a evolução continua.
+ *
+ * Chame uma vez com a população inicial (geracao 0, ou a geração retomada)
+ * e depois de cada nova geração; quando retorna 1, a configuração da lista
+ * já traz a taxa de mutação e o tamanho da próxima geração.
+ * @param controlador Ponteiro para o controlador.
+ * @param lista Ponteiro para a lista.
+ * @param geracao Gerações concluídas até aqui.
+ * @return 1 para continuar, 0 para encerrar (veja estado_execucao()).
+ */
+int controlar_execucao(Controlador *controlador, Lista *lista, int geracao);
+
+/**
+ * @brief Como controlar_execucao(), considerando todas as ilhas do arquipélago.
+ * @param controlador Ponteiro para o controlador.
+ * @param arquipelago Ponteiro para o arquipélago.
+ * @param geracao Gerações concluídas até aqui.
+ * @return 1 para continuar, 0 para encerrar.
+ */
+int controlar_arquipelago(Controlador *controlador, Arquipelago *arquipelago, int geracao);
+
+/**
+ * @brief Retorna o estado atual do controlador.
+ */
+const EstadoExecucao *estado_execucao(const Controlador *controlador);
+
+/**
+ * @brief Retorna uma descrição curta do motivo de parada.
+ */
+const char *descrever_parada(MotivoParada motivo);
+
+/**
+ * @brief Libera o controlador.
+ */
+void liberar_controlador(Controlador *controlador);
+
+/**
+ * @brief Atende coordenadores de avaliação distribuída em um endereço.
+ *
+ * O mapa é carregado uma vez por quem chama e fica residente; cada conexão
+ * é atendida até o coordenador fechá-la, uma de cada vez. Só retorna em
+ * caso de erro.
+ * @param matriz Ponteiro para a matriz do mapa (a mesma do coordenador).
+ * @param endereco "unix:/caminho", "host:porta" ou "porta" (TCP).
+ * @return 0 se não foi possível escutar no endereço.
+ */
+int servir_avaliacao(Matriz *matriz, const char *endereco);
+
+/**
+ * @brief Conecta o coordenador a trabalhadores já em execução.
+ *
+ * Cada trabalhador confirma, na conexão, que usa o mesmo mapa.
+ * @param matriz Ponteiro para a matriz do mapa.
+ * @param enderecos Lista separada por vírgulas, no formato de servir_avaliacao().
+ * @return Ponteiro para o distribuidor, ou NULL em caso de erro.
+ */
+Distribuidor *cria_distribuidor(Matriz *matriz, const char *enderecos);
+
+/**
+ * @brief Cria trabalhadores locais com fork(), ligados por sockets Unix.
+ *
+ * Deve ser chamada antes de criar threads no processo. Os trabalhadores
+ * terminam quando o distribuidor é liberado.
+ * @param matriz Ponteiro para a matriz do mapa, herdada pelos trabalhadores.
+ * @param num_trabalhadores Número de processos trabalhadores.
+ * @return Ponteiro para o distribuidor, ou NULL em caso de erro.
+ */
+Distribuidor *cria_distribuidor_local(Matriz *matriz, int num_trabalhadores);
+
+/**
+ * @brief Retorna o número de trabalhadores conectados.
+ */
+int numero_trabalhadores(const Distribuidor *distribuidor);
+
+/**
+ * @brief Avalia indivíduos nos trabalhadores, como avaliar_lote().
+ * @param distribuidor Ponteiro para o distribuidor.
+ * @param individuos Vetor de ponteiros para os indivíduos.
+ * @param n Número de indivíduos.
+ * @return 1 em caso de sucesso, 0 em erro de comunicação.
+ */
+int avaliar_remoto(Distribuidor *distribuidor, No **individuos, int n);
+
+/**
+ * @brief Gera a nova geração localmente e avalia os indivíduos nos trabalhadores.
+ *
+ * O crossover, a mutação e os passeios usam o gerador global, na mesma
+ * ordem de nova_geracao(), e o resultado é o mesmo para a mesma semente.
+ * @param geracao_atual Ponteiro para a lista da geração atual.
+ * @param distribuidor Ponteiro para o distribuidor.
+ * @return A própria lista, já com a nova geração, ou NULL em caso de erro.
+ */
+Lista *nova_geracao_distribuida(Lista *geracao_atual, Distribuidor *distribuidor);
+
+/**
+ * @brief Fecha as conexões e espera os trabalhadores locais terminarem.
+ * @param distribuidor Ponteiro para o distribuidor.
+ */
+void liberar_distribuidor(Distribuidor *distribuidor);
+
+/**
+ * @brief Libera a memória ocupada por uma lista de indivíduos, incluindo suas arenas.
  * @param lista Ponteiro para a lista a ser liberada.
  */
 void liberar_lista(Lista *lista);
@@ -148,6 +827,156 @@ void salvar_individuo_csv(No *no, void *contexto);
  */
 void salvar_lista_csv(Lista *lista, const char *nome_arquivo);
 
+/**
+ * @brief Abre um arquivo para gravar populações a cada geração.
+ *
+ * A formatação, a compressão e a escrita são feitas em uma thread própria,
+ * com buffers de 1 MiB, em paralelo com a evolução. A compressão divide o
+ * arquivo em blocos independentes (sequências no estilo LZ4), que
+ * descomprimir_arquivo() expande.
+ * @param arquivo Caminho do arquivo de saída.
+ * @param formato SAIDA_CSV ou SAIDA_BINARIA.
+ * @param comprimir Diferente de 0 para comprimir em blocos.
+ * @param espacos Gerações que a fila guarda enquanto a escrita não as alcança (ao menos 1).
+ * @param descartar Diferente de 0 para descartar gerações com a fila cheia em vez de esperar.
+ * @return Ponteiro para o gravador, ou NULL em caso de erro.
+ */
+Gravador *cria_gravador(const char *arquivo, FormatoSaida formato, int comprimir, int espacos, int descartar);
+
+/**
+ * @brief Enfileira a população atual da lista para gravação.
+ *
+ * Apenas copia os indivíduos (genótipo compactado e métricas) para um dos
+ * espaços da fila e retorna. Se todos os espaços estiverem ocupados, espera
+ * a escrita liberar um; se o gravador descarta, a geração é contada e
+ * gravada sem indivíduos, marcando a lacuna no arquivo. Deve ser chamada
+ * sempre pela mesma thread.
+ * @param gravador Ponteiro para o gravador.
+ * @param lista Lista cuja geração atual será gravada.
+ * @param geracao Número da geração, gravado com cada indivíduo.
+ * @return 1 se a geração foi enfileirada, 0 se foi descartada ou em erro.
+ */
+int gravar_populacao(Gravador *gravador, Lista *lista, int geracao);
+
+/**
+ * @brief Retorna quantas gerações foram descartadas por falta de espaço na fila.
+ */
+unsigned long long geracoes_descartadas(Gravador *gravador);
+
+/**
+ * @brief Grava o que estiver pendente, fecha o arquivo e libera o gravador.
+ * @param gravador Ponteiro para o gravador.
+ * @return 1 se tudo foi gravado, 0 em erro de escrita.
+ */
+int fechar_gravador(Gravador *gravador);
+
+/**
+ * @brief Expande um arquivo comprimido por um Gravador.
+ * @param entrada Arquivo comprimido.
+ * @param saida Arquivo onde o conteúdo original (CSV ou binário) será gravado.
+ * @return 1 em caso de sucesso, 0 em erro ou dados corrompidos.
+ */
+int descomprimir_arquivo(const char *entrada, const char *saida);
+
+/**
+ * @brief Cria um salvamento do estado da execução, gravado em segundo plano.
+ *
+ * O estado (população, geradores, parâmetros, geração e assinatura do
+ * mapa) é gravado em `arquivo`.tmp e renomeado para `arquivo` quando
+ * completo, de modo que uma interrupção não destrói o estado anterior.
+ * @param arquivo Caminho do arquivo de estado.
+ * @return Ponteiro para o salvamento, ou NULL em caso de erro.
+ */
+Salvamento *cria_salvamento(const char *arquivo);
+
+/**
+ * @brief Copia o estado atual para gravação em segundo plano.
+ *
+ * A cópia é feita na hora, entre gerações, e a escrita fica com a thread do
+ * salvamento. Se o estado anterior ainda não tiver sido entregue à thread,
+ * retorna sem salvar, a menos que `esperar` seja diferente de 0.
+ * @param salvamento Ponteiro para o salvamento.
+ * @param lista Lista com a população atual.
+ * @param matriz Mapa da execução, identificado por sua assinatura.
+ * @param pool Pool de threads da execução (seus geradores são salvos), ou NULL.
+ * @param controlador Controlador da execução (seu estado e os valores originais dos
+ *                    cronogramas são salvos), ou NULL.
+ * @param geracao Gerações já concluídas.
+ * @param esperar Diferente de 0 para nunca descartar este estado.
+ * @return 1 se o estado foi copiado, 0 se foi descartado ou em erro.
+ */
+int salvar_estado(Salvamento *salvamento, Lista *lista, const Matriz *matriz, PoolThreads *pool,
+                  const Controlador *controlador, int geracao, int esperar);
+
+/**
+ * @brief Grava o estado pendente e libera o salvamento.
+ * @param salvamento Ponteiro para o salvamento.
+ * @return 1 se todas as gravações tiveram sucesso, 0 caso contrário.
+ */
+int fechar_salvamento(Salvamento *salvamento);
+
+/**
+ * @brief Lê de um arquivo de estado os parâmetros que afetam a evolução.
+ *
+ * Sobrescreve população, elite, filhos, mutação, comprimentos, codificação,
+ * modo de fitness, threads, semente, mutação adaptativa e população mínima;
+ * população e mutação voltam aos valores de antes dos cronogramas. Os
+ * caminhos, o número de gerações e os critérios de parada são mantidos. Use
+ * antes de criar o pool e o controlador, para que o número de threads e os
+ * cronogramas coincidam.
+ * @param arquivo Arquivo gravado por salvar_estado().
+ * @param config Configuração a atualizar.
+ * @return 1 em caso de sucesso, 0 se o arquivo for inválido.
+ */
+int ler_configuracao_estado(const char *arquivo, Configuracao *config);
+
+/**
+ * @brief Recria a população e os geradores a partir de um arquivo de estado.
+ *
+ * Restaura o gerador global e, com `pool`, os geradores de cada thread. O
+ * mapa deve estar no modo de fitness da execução salva; continuando a
+ * evolução do mesmo modo, o resultado é idêntico ao de uma execução sem
+ * interrupção.
+ * @param arquivo Arquivo gravado por salvar_estado().
+ * @param matriz O mesmo mapa da execução salva.
+ * @param pool Pool com o mesmo número de threads da execução salva, ou NULL.
+ * @param controlador Recebe o estado salvo do controlador (gerações sem
+ *                    melhora, avaliações, mutação, tempo decorrido), ou NULL.
+ * @param geracao Recebe o número de gerações já concluídas.
+ * @return A lista restaurada, ou NULL em caso de erro.
+ */
+Lista *restaurar_estado(const char *arquivo, const Matriz *matriz, PoolThreads *pool, Controlador *controlador,
+                        int *geracao);
+
+/**
+ * @brief Totais de uma execução em lote.
+ */
+typedef struct _resumo_lote {
+    int mapas;                      /**< Mapas listados. */
+    int resolvidos;                 /**< Mapas em que algum indivíduo chegou ao objetivo. */
+    int falhas;                     /**< Mapas que não puderam ser carregados ou executados. */
+    unsigned long long avaliacoes;  /**< Indivíduos avaliados em todos os mapas. */
+    double segundos;                /**< Duração total do lote. */
+} ResumoLote;
+
+/**
+ * @brief Executa o algoritmo uma vez em cada mapa de um diretório ou manifesto.
+ *
+ * config->arquivo_lote é um diretório (seus arquivos, em ordem de nome) ou
+ * um manifesto com um mapa por linha. Os mapas são divididos entre
+ * config->threads trabalhadores com roubo de tarefas; cada trabalhador
+ * reaproveita a sua lista e o seu avaliador de um mapa para o outro, e cada
+ * mapa usa a semente config->semente mais o seu índice, de modo que o
+ * resultado não depende do número de threads. Os critérios de parada do
+ * controlador valem por mapa. Grava uma linha por mapa em
+ * config->arquivo_saida e, se definido, o resumo em config->arquivo_resumo.
+ * @param config Configuração da execução, com arquivo_lote definido.
+ * @param resumo Recebe os totais do lote; pode ser NULL.
+ * @return 1 se o lote foi executado e os arquivos gravados, 0 caso contrário
+ *         (mapas inválidos só contam como falhas).
+ */
+int resolver_lote(const Configuracao *config, ResumoLote *resumo);
+
 /**
  * @brief Obtém o próximo nó da lista encadeada.
  * @param no Ponteiro para o nó atual.
@@ -0,0 +1,439 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "algen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Benchmark do algoritmo genético sobre labirintos sintéticos. Cada etapa é
+ * cronometrada separadamente e o resultado sai em JSON. */
+
+#define MAX_TAMANHOS 32
+#define ARQUIVO_CSV_PADRAO "benchmark_saida.csv"
+
+typedef enum {
+    LABIRINTO,  /* backtracker recursivo: corredores de largura 1, sem ciclos */
+    SALAS,      /* salas abertas ligadas por portas */
+    BECOS       /* pente: um corredor com muitos becos sem saída longos */
+} TipoLabirinto;
+
+static const char *nomes_tipos[] = {"labirinto", "salas", "becos"};
+
+typedef enum {
+    ETAPA_GERAR_MAPA,
+    ETAPA_CRIAR_MAPA,
+    ETAPA_POPULACAO_INICIAL,
+    ETAPA_NOVA_GERACAO,
+    ETAPA_SAIDA,
+    TOTAL_ETAPAS
+} Etapa;
+
+static const char *nomes_etapas[] = {
+    "gerar_mapa", "criar_mapa", "populacao_inicial", "nova_geracao", "saida"
+};
+
+typedef struct {
+    unsigned int linhas, colunas;
+} Tamanho;
+
+typedef struct {
+    Tamanho tamanhos[MAX_TAMANHOS];
+    int num_tamanhos;
+    int tipos[3];
+    int num_tipos;
+    int repeticoes;
+    int compactar;
+    const char *arquivo_json;
+    const char *arquivo_csv;
+    Configuracao config;
+} Parametros;
+
+typedef struct {
+    unsigned long long ns[TOTAL_ETAPAS];
+    unsigned long long ns_geracao[TELEMETRIA_TOTAL_ETAPAS];  /* nova_geracao por dentro, pela telemetria */
+    size_t celulas_livres;
+    float melhor_fitness;
+} Medicao;
+
+static unsigned long long agora_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (unsigned long long)t.tv_sec * 1000000000ull + (unsigned long long)t.tv_nsec;
+}
+
+/* ---- Gerador de labirintos ---- */
+
+static uint64_t proximo_aleatorio(uint64_t *estado) {
+    uint64_t z = (*estado += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static unsigned int sortear(uint64_t *estado, unsigned int n) {
+    return (unsigned int)(((proximo_aleatorio(estado) >> 32) * n) >> 32);
+}
+
+/* Cavamos as células de coordenadas pares; as ímpares entre duas células
+ * vizinhas viram passagem quando o caminho as atravessa. */
+static int gerar_backtracker(char *celulas, unsigned int linhas, unsigned int colunas, uint64_t *estado) {
+    size_t ci = (linhas + 1) / 2, cj = (colunas + 1) / 2;
+    size_t total = ci * cj;
+    unsigned char *visitada = calloc(total, 1);
+    uint32_t *pilha = malloc(total * sizeof(uint32_t));
+    if (!visitada || !pilha) {
+        free(visitada);
+        free(pilha);
+        return 0;
+    }
+    memset(celulas, '#', (size_t)linhas * colunas);
+
+    static const int di[4] = {-1, 1, 0, 0};
+    static const int dj[4] = {0, 0, -1, 1};
+    size_t topo = 0;
+    pilha[topo++] = 0;
+    visitada[0] = 1;
+    celulas[0] = '.';
+    while (topo > 0) {
+        uint32_t atual = pilha[topo - 1];
+        long i = (long)(atual / cj), j = (long)(atual % cj);
+        int opcoes[4], n = 0;
+        for (int d = 0; d < 4; d++) {
+            long ni = i + di[d], nj = j + dj[d];
+            if (ni >= 0 && nj >= 0 && ni < (long)ci && nj < (long)cj && !visitada[ni * cj + nj])
+                opcoes[n++] = d;
+        }
+        if (n == 0) {
+            topo--;
+            continue;
+        }
+        int d = opcoes[sortear(estado, (unsigned int)n)];
+        long ni = i + di[d], nj = j + dj[d];
+        celulas[(size_t)(2 * i + di[d]) * colunas + (size_t)(2 * j + dj[d])] = '.';
+        celulas[(size_t)(2 * ni) * colunas + (size_t)(2 * nj)] = '.';
+        visitada[ni * cj + nj] = 1;
+        pilha[topo++] = (uint32_t)(ni * cj + nj);
+    }
+    free(visitada);
+    free(pilha);
+
+    celulas[0] = 'S';
+    celulas[(size_t)(2 * (ci - 1)) * colunas + 2 * (cj - 1)] = 'E';
+    return 1;
+}
+
+/* Salas de 9x9 separadas por paredes; cada trecho de parede entre dois
+ * cruzamentos recebe uma porta em posição aleatória. */
+static void gerar_salas(char *celulas, unsigned int linhas, unsigned int colunas, uint64_t *estado) {
+    const unsigned int lado = 10;
+    memset(celulas, '.', (size_t)linhas * colunas);
+    for (unsigned int i = lado - 1; i + 1 < linhas; i += lado) {
+        memset(celulas + (size_t)i * colunas, '#', colunas);
+        for (unsigned int j = 0; j < colunas; j += lado) {
+            unsigned int largura = colunas - j < lado - 1 ? colunas - j : lado - 1;
+            celulas[(size_t)i * colunas + j + sortear(estado, largura)] = '.';
+        }
+    }
+    for (unsigned int j = lado - 1; j + 1 < colunas; j += lado) {
+        for (unsigned int i = 0; i < linhas; i++) {
+            if (i % lado != lado - 1) celulas[(size_t)i * colunas + j] = '#';
+        }
+        for (unsigned int i = 0; i < linhas; i += lado) {
+            unsigned int altura = linhas - i < lado - 1 ? linhas - i : lado - 1;
+            celulas[(size_t)(i + sortear(estado, altura)) * colunas + j] = '.';
+        }
+    }
+    celulas[0] = 'S';
+    celulas[(size_t)linhas * colunas - 1] = 'E';
+}
+
+/* Pente: a primeira coluna é o corredor principal e cada linha par é um
+ * dente que termina em parede; o objetivo fica no fim do último dente. */
+static void gerar_becos(char *celulas, unsigned int linhas, unsigned int colunas) {
+    for (unsigned int i = 0; i < linhas; i++) {
+        char *linha = celulas + (size_t)i * colunas;
+        int dente = (i % 2 == 0) || i == linhas - 1;
+        memset(linha, dente ? '.' : '#', colunas);
+        linha[0] = '.';
+    }
+    celulas[0] = 'S';
+    celulas[(size_t)linhas * colunas - 1] = 'E';
+}
+
+static char *gerar_celulas(TipoLabirinto tipo, unsigned int linhas, unsigned int colunas, uint64_t semente) {
+    char *celulas = malloc((size_t)linhas * colunas);
+    if (!celulas) return NULL;
+    uint64_t estado = semente;
+    switch (tipo) {
+    case LABIRINTO:
+        if (!gerar_backtracker(celulas, linhas, colunas, &estado)) {
+            free(celulas);
+            return NULL;
+        }
+        break;
+    case SALAS:
+        gerar_salas(celulas, linhas, colunas, &estado);
+        break;
+    case BECOS:
+        gerar_becos(celulas, linhas, colunas);
+        break;
+    }
+    return celulas;
+}
+
+/* ---- Execução cronometrada ---- */
+
+/* As etapas internas de nova_geracao vêm da telemetria da própria lista:
+ * são exatamente as ordenações, avaliações etc. que a geração fez. */
+static void acumular_telemetria(const EstatisticasGeracao *estatisticas, void *contexto) {
+    Medicao *m = contexto;
+    for (int e = 0; e < TELEMETRIA_TOTAL_ETAPAS; e++)
+        m->ns_geracao[e] += estatisticas->ns[e];
+    m->melhor_fitness = estatisticas->melhor_fitness;
+}
+
+static int medir(const Parametros *p, TipoLabirinto tipo, Tamanho tamanho, uint64_t semente, Medicao *m) {
+    memset(m, 0, sizeof(*m));
+    unsigned long long t = agora_ns();
+    char *celulas = gerar_celulas(tipo, tamanho.linhas, tamanho.colunas, semente);
+    m->ns[ETAPA_GERAR_MAPA] = agora_ns() - t;
+    if (!celulas) {
+        fprintf(stderr, "Erro ao gerar o labirinto %ux%u\n", tamanho.linhas, tamanho.colunas);
+        return 0;
+    }
+    size_t total = (size_t)tamanho.linhas * tamanho.colunas;
+    for (size_t i = 0; i < total; i++)
+        m->celulas_livres += celulas[i] != '#';
+
+    t = agora_ns();
+    Matriz *matriz = criar_mapa(tamanho.linhas, tamanho.colunas, celulas);
+    if (matriz && p->compactar) compactar_mapa(matriz);
+    m->ns[ETAPA_CRIAR_MAPA] = agora_ns() - t;
+    free(celulas);
+    if (!matriz) return 0;
+
+    semear_aleatorio(semente);
+    Lista *populacao = cria_lista_configurada(&p->config);
+    PoolThreads *pool = NULL;
+    if (populacao && p->config.threads > 1)
+        pool = cria_pool_threads(matriz, p->config.threads, semente);
+    if (!populacao || (p->config.threads > 1 && !pool)) {
+        liberar_lista(populacao);
+        liberar_matriz(matriz);
+        return 0;
+    }
+
+    t = agora_ns();
+    insere_elementos(populacao, matriz, p->config.tamanho_populacao);
+    m->ns[ETAPA_POPULACAO_INICIAL] = agora_ns() - t;
+
+    definir_telemetria(populacao, acumular_telemetria, m);
+    int ok = 1;
+    for (int g = 0; g < p->config.geracoes && ok; g++) {
+        t = agora_ns();
+        ok = (pool ? nova_geracao_paralela(populacao, pool) : nova_geracao(populacao, matriz)) != NULL;
+        m->ns[ETAPA_NOVA_GERACAO] += agora_ns() - t;
+    }
+
+    if (ok) {
+        t = agora_ns();
+        salvar_lista_csv(populacao, p->arquivo_csv);
+        m->ns[ETAPA_SAIDA] = agora_ns() - t;
+        remove(p->arquivo_csv);
+    }
+
+    liberar_pool_threads(pool);
+    liberar_lista(populacao);
+    liberar_matriz(matriz);
+    return ok;
+}
+
+/* ---- Linha de comando e JSON ---- */
+
+static void imprimir_uso(const char *programa) {
+    printf("Uso: %s [opcoes]\n", programa);
+    printf("  --tamanhos LISTA      lados dos labirintos, ex.: 10,100,1000 ou 200x500 (padrao: 10,100,1000)\n");
+    printf("  --tipos LISTA         labirinto, salas e/ou becos (padrao: todos)\n");
+    printf("  -p, --populacao N     individuos por geracao (padrao: 100)\n");
+    printf("  -g, --geracoes N      geracoes por medicao (padrao: 10)\n");
+    printf("  -r, --repeticoes N    repeticoes; vale o menor tempo de cada etapa (padrao: 3)\n");
+    printf("  -s, --semente N       semente dos labirintos e da evolucao (padrao: 1)\n");
+    printf("  -j, --threads N       threads na construcao das geracoes (padrao: 1)\n");
+    printf("      --compacto        genotipos com 2 bits por movimento\n");
+    printf("      --compactar-mapa  descarta os caracteres do mapa apos a criacao\n");
+    printf("  -o, --saida ARQUIVO   arquivo JSON (padrao: saida padrao)\n");
+    printf("      --csv ARQUIVO     arquivo temporario da etapa de saida (padrao: %s)\n", ARQUIVO_CSV_PADRAO);
+}
+
+static int ler_inteiro(const char *texto, int *valor) {
+    char *fim;
+    long v = strtol(texto, &fim, 10);
+    if (*texto == '\0' || *fim != '\0' || v < -2147483647L || v > 2147483647L) return 0;
+    *valor = (int)v;
+    return 1;
+}
+
+static int ler_semente(const char *texto, unsigned long long *valor) {
+    char *fim;
+    if (*texto == '\0' || *texto == '-') return 0;
+    unsigned long long v = strtoull(texto, &fim, 10);
+    if (*fim != '\0') return 0;
+    *valor = v;
+    return 1;
+}
+
+static int ler_tamanhos(const char *texto, Parametros *p) {
+    p->num_tamanhos = 0;
+    while (*texto) {
+        char *fim;
+        unsigned long linhas = strtoul(texto, &fim, 10), colunas = linhas;
+        if (*fim == 'x') colunas = strtoul(fim + 1, &fim, 10);
+        if (fim == texto || linhas < 2 || colunas < 2 || linhas > 100000 || colunas > 100000
+            || (*fim != ',' && *fim != '\0') || p->num_tamanhos == MAX_TAMANHOS)
+            return 0;
+        p->tamanhos[p->num_tamanhos++] = (Tamanho){(unsigned int)linhas, (unsigned int)colunas};
+        texto = *fim ? fim + 1 : fim;
+    }
+    return p->num_tamanhos > 0;
+}
+
+static int ler_tipos(const char *texto, Parametros *p) {
+    p->num_tipos = 0;
+    while (*texto) {
+        size_t n = strcspn(texto, ",");
+        int achou = 0;
+        for (int t = 0; t < 3; t++) {
+            if (strlen(nomes_tipos[t]) == n && strncmp(texto, nomes_tipos[t], n) == 0) {
+                p->tipos[p->num_tipos++] = t;
+                achou = 1;
+                break;
+            }
+        }
+        if (!achou || p->num_tipos > 3) return 0;
+        texto += n;
+        if (*texto == ',') texto++;
+    }
+    return p->num_tipos > 0;
+}
+
+static int ler_argumentos(int argc, char **argv, Parametros *p) {
+    for (int i = 1; i < argc; i++) {
+        const char *opcao = argv[i];
+        if (strcmp(opcao, "-h") == 0 || strcmp(opcao, "--ajuda") == 0) {
+            imprimir_uso(argv[0]);
+            return 0;
+        }
+        if (strcmp(opcao, "--compacto") == 0) {
+            p->config.genoma_compacto = 1;
+            continue;
+        }
+        if (strcmp(opcao, "--compactar-mapa") == 0) {
+            p->compactar = 1;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Opcao desconhecida ou sem valor: %s\n", opcao);
+            return -1;
+        }
+        const char *valor = argv[++i];
+        int ok = 1;
+        if (strcmp(opcao, "--tamanhos") == 0) ok = ler_tamanhos(valor, p);
+        else if (strcmp(opcao, "--tipos") == 0) ok = ler_tipos(valor, p);
+        else if (strcmp(opcao, "-p") == 0 || strcmp(opcao, "--populacao") == 0)
+            ok = ler_inteiro(valor, &p->config.tamanho_populacao);
+        else if (strcmp(opcao, "-g") == 0 || strcmp(opcao, "--geracoes") == 0)
+            ok = ler_inteiro(valor, &p->config.geracoes);
+        else if (strcmp(opcao, "-r") == 0 || strcmp(opcao, "--repeticoes") == 0)
+            ok = ler_inteiro(valor, &p->repeticoes) && p->repeticoes > 0;
+        else if (strcmp(opcao, "-s") == 0 || strcmp(opcao, "--semente") == 0)
+            ok = ler_semente(valor, &p->config.semente);
+        else if (strcmp(opcao, "-j") == 0 || strcmp(opcao, "--threads") == 0)
+            ok = ler_inteiro(valor, &p->config.threads);
+        else if (strcmp(opcao, "-o") == 0 || strcmp(opcao, "--saida") == 0) p->arquivo_json = valor;
+        else if (strcmp(opcao, "--csv") == 0) p->arquivo_csv = valor;
+        else {
+            fprintf(stderr, "Opcao desconhecida: %s\n", opcao);
+            return -1;
+        }
+        if (!ok) {
+            fprintf(stderr, "Valor invalido para %s: %s\n", opcao, valor);
+            return -1;
+        }
+    }
+    return validar_configuracao(&p->config) ? 1 : -1;
+}
+
+static void escrever_resultado(FILE *saida, TipoLabirinto tipo, Tamanho tamanho,
+                               const Medicao *m, int primeiro) {
+    fprintf(saida, "%s    {\"tipo\": \"%s\", \"linhas\": %u, \"colunas\": %u, \"celulas_livres\": %zu,\n",
+            primeiro ? "" : ",\n", nomes_tipos[tipo], tamanho.linhas, tamanho.colunas, m->celulas_livres);
+    fprintf(saida, "     \"etapas_ns\": {");
+    for (int e = 0; e < TOTAL_ETAPAS; e++)
+        fprintf(saida, "%s\"%s\": %llu", e ? ", " : "", nomes_etapas[e], m->ns[e]);
+    fprintf(saida, "},\n     \"nova_geracao_ns\": {");
+    for (int e = 0; e < TELEMETRIA_TOTAL_ETAPAS; e++)
+        fprintf(saida, "%s\"%s\": %llu", e ? ", " : "", nome_etapa_telemetria((EtapaTelemetria)e), m->ns_geracao[e]);
+    fprintf(saida, "},\n     \"melhor_fitness\": %.4f}", (double)m->melhor_fitness);
+}
+
+int main(int argc, char **argv) {
+    Parametros p;
+    memset(&p, 0, sizeof(p));
+    p.config = configuracao_padrao();
+    p.config.geracoes = 10;
+    p.config.semente = 1;
+    p.repeticoes = 3;
+    p.arquivo_csv = ARQUIVO_CSV_PADRAO;
+    ler_tamanhos("10,100,1000", &p);
+    ler_tipos("labirinto,salas,becos", &p);
+
+    int status = ler_argumentos(argc, argv, &p);
+    if (status <= 0) return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    FILE *saida = stdout;
+    if (p.arquivo_json) {
+        saida = fopen(p.arquivo_json, "w");
+        if (!saida) {
+            fprintf(stderr, "Falha ao abrir arquivo %s\n", p.arquivo_json);
+            return EXIT_FAILURE;
+        }
+    }
+
+    fprintf(saida, "{\n  \"semente\": %llu, \"populacao\": %d, \"geracoes\": %d, \"repeticoes\": %d,\n",
+            p.config.semente, p.config.tamanho_populacao, p.config.geracoes, p.repeticoes);
+    fprintf(saida, "  \"threads\": %d, \"genoma_compacto\": %s, \"mapa_compactado\": %s,\n",
+            p.config.threads, p.config.genoma_compacto ? "true" : "false", p.compactar ? "true" : "false");
+    fprintf(saida, "  \"resultados\": [\n");
+
+    int primeiro = 1, falhas = 0;
+    for (int t = 0; t < p.num_tipos; t++) {
+        for (int k = 0; k < p.num_tamanhos; k++) {
+            TipoLabirinto tipo = (TipoLabirinto)p.tipos[t];
+            Tamanho tamanho = p.tamanhos[k];
+            fprintf(stderr, "%s %ux%u...\n", nomes_tipos[tipo], tamanho.linhas, tamanho.colunas);
+
+            // Vale o menor tempo de cada etapa entre as repetições
+            Medicao melhor, m;
+            int ok = medir(&p, tipo, tamanho, p.config.semente, &melhor);
+            for (int r = 1; r < p.repeticoes && ok; r++) {
+                ok = medir(&p, tipo, tamanho, p.config.semente, &m);
+                for (int e = 0; e < TOTAL_ETAPAS; e++)
+                    if (m.ns[e] < melhor.ns[e]) melhor.ns[e] = m.ns[e];
+                for (int e = 0; e < TELEMETRIA_TOTAL_ETAPAS; e++)
+                    if (m.ns_geracao[e] < melhor.ns_geracao[e]) melhor.ns_geracao[e] = m.ns_geracao[e];
+            }
+            if (!ok) {
+                fprintf(stderr, "Falha na medicao de %s %ux%u\n", nomes_tipos[tipo], tamanho.linhas, tamanho.colunas);
+                falhas++;
+                continue;
+            }
+            escrever_resultado(saida, tipo, tamanho, &melhor, primeiro);
+            primeiro = 0;
+        }
+    }
+    fprintf(saida, "\n  ]\n}\n");
+    if (saida != stdout) fclose(saida);
+    return falhas ? EXIT_FAILURE : EXIT_SUCCESS;
+}
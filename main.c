@@ -1,46 +1,504 @@
 #include "algen.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
-#define ARQUIVO_MAPA "C:\\Users\\Ryan\\Documents\\VSCODE\\Linguagem C\\TRABALHO_DE_ED_(Oficial)\\matriz.txt"
+static void imprimir_uso(const char *programa) {
+    Configuracao padrao = configuracao_padrao();
+    printf("Uso: %s [opcoes]\n", programa);
+    printf("  -m, --mapa ARQUIVO        mapa do labirinto (padrao: %s)\n", padrao.arquivo_mapa);
+    printf("  -o, --saida ARQUIVO       CSV com a populacao final (padrao: %s)\n", padrao.arquivo_saida);
+    printf("  -g, --geracoes N          numero de geracoes (padrao: %d)\n", padrao.geracoes);
+    printf("  -p, --populacao N         individuos por geracao (padrao: %d)\n", padrao.tamanho_populacao);
+    printf("  -e, --elite N             melhores mantidos a cada geracao (padrao: %d)\n", padrao.elite);
+    printf("  -f, --filhos N            maximo de filhos por crossover (padrao: %d)\n", padrao.max_filhos);
+    printf("  -t, --taxa-mutacao X      probabilidade de mutacao por movimento (padrao: %.2f)\n", padrao.taxa_mutacao);
+    printf("  -c, --tam-filho N         movimentos de cada filho (padrao: %d)\n", padrao.tam_filho);
+    printf("      --passeio-min N       menor passeio aleatorio (padrao: %d)\n", padrao.passeio_min);
+    printf("      --passeio-max N       maior passeio aleatorio (padrao: %d)\n", padrao.passeio_max);
+    printf("  -s, --semente N           semente do gerador; 0 usa o relogio (padrao: 0)\n");
+    printf("  -j, --threads N           threads na construcao das geracoes (padrao: %d)\n", padrao.threads);
+    printf("      --compacto            guarda os genotipos com 2 bits por movimento\n");
+    printf("      --fitness MODO        distancia ao objetivo: manhattan ou caminho (padrao: manhattan)\n");
+    printf("      --selecao MODO        escolha dos pais: vizinhos, torneio, amostragem ou ranking (padrao: vizinhos)\n");
+    printf("      --torneio K           sorteados em cada torneio (padrao: %d)\n", padrao.tamanho_torneio);
+    printf("      --pressao S           copias esperadas do melhor no ranking, de 1 a 2 (padrao: %.1f)\n",
+           padrao.pressao_ranking);
+    printf("      --crossover MODO      montagem dos filhos: metades, um-ponto, dois-pontos ou posicional (padrao: metades)\n");
+    printf("      --estacionario N      modo estacionario: lotes de N filhos substituem os piores (padrao: desligado)\n");
+    printf("      --cache N             entradas do cache de fitness dos filhos; 0 desliga (padrao: %d)\n",
+           padrao.cache_fitness);
+    printf("      --ilhas N             populacoes independentes com migracao (padrao: 1)\n");
+    printf("      --intervalo-migracao N  geracoes entre migracoes; 0 desliga (padrao: %d)\n", padrao.intervalo_migracao);
+    printf("      --migrantes N         melhores enviados a ilha vizinha (padrao: %d)\n", padrao.migrantes);
+    printf("      --trabalhadores LISTA avalia em trabalhadores remotos (unix:/caminho ou host:porta)\n");
+    printf("      --trabalhadores-locais N  cria N processos trabalhadores locais\n");
+    printf("      --servir ENDERECO     atende como trabalhador de avaliacao no endereco\n");
+    printf("      --converter ARQUIVO   grava o mapa no formato binario e sai\n");
+    printf("      --sem-metadados       na conversao, grava so o bitset (sem vizinhanca e distancias)\n");
+    printf("      --populacoes ARQUIVO  grava a populacao de cada geracao (padrao: desligada)\n");
+    printf("      --populacoes-binario  populacoes em formato binario em vez de CSV\n");
+    printf("      --comprimir           comprime o arquivo de populacoes em blocos\n");
+    printf("      --fila-populacoes N   geracoes na fila do gravador de populacoes (padrao: %d)\n",
+           padrao.fila_populacoes);
+    printf("      --descartar-populacoes  com a fila cheia, descarta a geracao (marcada no arquivo) em vez de esperar\n");
+    printf("      --descomprimir ARQUIVO  expande um arquivo comprimido no caminho de -o e sai\n");
+    printf("      --estado ARQUIVO      salva o estado completo para retomar a execucao (padrao: desligado)\n");
+    printf("      --intervalo-estado N  segundos entre salvamentos do estado; 0 a cada geracao (padrao: %d)\n",
+           padrao.intervalo_estado);
+    printf("      --retomar ARQUIVO     continua a execucao salva ate o numero de geracoes de -g\n");
+    printf("      --parar-no-objetivo   encerra quando algum individuo chega ao objetivo\n");
+    printf("      --sem-melhora N       encerra apos N geracoes sem melhorar o melhor fitness\n");
+    printf("      --tempo-limite S      encerra apos S segundos\n");
+    printf("      --max-avaliacoes N    encerra apos N individuos avaliados\n");
+    printf("      --mutacao-adaptativa  reduz a mutacao enquanto o melhor fitness nao melhora\n");
+    printf("      --populacao-minima N  reduz a populacao linearmente ate N na ultima geracao\n");
+    printf("      --telemetria ARQUIVO  tempos e estatisticas de cada geracao (padrao: desligada)\n");
+    printf("      --telemetria-json     telemetria em linhas JSON em vez de CSV\n");
+    printf("      --lote CAMINHO        resolve cada mapa de um diretorio ou manifesto; resultados em -o\n");
+    printf("      --resumo ARQUIVO      CSV com o resumo do lote (padrao: desligado)\n");
+    printf("  -h, --ajuda               mostra esta mensagem\n");
+}
+
+static int ler_inteiro(const char *texto, int *valor) {
+    char *fim;
+    long v = strtol(texto, &fim, 10);
+    if (*texto == '\0' || *fim != '\0' || v < -2147483647L || v > 2147483647L) return 0;
+    *valor = (int)v;
+    return 1;
+}
+
+static int ler_real(const char *texto, float *valor) {
+    char *fim;
+    double v = strtod(texto, &fim);
+    if (*texto == '\0' || *fim != '\0') return 0;
+    *valor = (float)v;
+    return 1;
+}
+
+static int ler_semente(const char *texto, unsigned long long *valor) {
+    char *fim;
+    if (*texto == '\0' || *texto == '-') return 0;
+    unsigned long long v = strtoull(texto, &fim, 10);
+    if (*fim != '\0') return 0;
+    *valor = v;
+    return 1;
+}
+
+/* Retorna 1 para executar, 0 para sair com sucesso (ajuda) e -1 em erro. */
+static int ler_argumentos(int argc, char **argv, Configuracao *config) {
+    for (int i = 1; i < argc; i++) {
+        const char *opcao = argv[i];
+        if (strcmp(opcao, "-h") == 0 || strcmp(opcao, "--ajuda") == 0) {
+            imprimir_uso(argv[0]);
+            return 0;
+        }
+        if (strcmp(opcao, "--compacto") == 0) {
+            config->genoma_compacto = 1;
+            continue;
+        }
+        if (strcmp(opcao, "--telemetria-json") == 0) {
+            config->telemetria_json = 1;
+            continue;
+        }
+        if (strcmp(opcao, "--sem-metadados") == 0) {
+            config->binario_sem_metadados = 1;
+            continue;
+        }
+        if (strcmp(opcao, "--populacoes-binario") == 0) {
+            config->populacoes_binario = 1;
+            continue;
+        }
+        if (strcmp(opcao, "--comprimir") == 0) {
+            config->comprimir_populacoes = 1;
+            continue;
+        }
+        if (strcmp(opcao, "--descartar-populacoes") == 0) {
+            config->descartar_populacoes = 1;
+            continue;
+        }
+        if (strcmp(opcao, "--parar-no-objetivo") == 0) {
+            config->parar_no_objetivo = 1;
+            continue;
+        }
+        if (strcmp(opcao, "--mutacao-adaptativa") == 0) {
+            config->mutacao_adaptativa = 1;
+            continue;
+        }
+
+        if (i + 1 >= argc) {
+            printf("Opcao desconhecida ou sem valor: %s\n", opcao);
+            return -1;
+        }
+        const char *valor = argv[++i];
+        int ok;
+        if (strcmp(opcao, "-m") == 0 || strcmp(opcao, "--mapa") == 0) {
+            config->arquivo_mapa = valor;
+            ok = 1;
+        } else if (strcmp(opcao, "-o") == 0 || strcmp(opcao, "--saida") == 0) {
+            config->arquivo_saida = valor;
+            ok = 1;
+        } else if (strcmp(opcao, "--fitness") == 0) {
+            ok = 1;
+            if (strcmp(valor, "manhattan") == 0) config->modo_fitness = FITNESS_MANHATTAN;
+            else if (strcmp(valor, "caminho") == 0) config->modo_fitness = FITNESS_CAMINHO;
+            else ok = 0;
+        } else if (strcmp(opcao, "--selecao") == 0) {
+            ok = 1;
+            if (strcmp(valor, "vizinhos") == 0) config->selecao = SELECAO_VIZINHOS;
+            else if (strcmp(valor, "torneio") == 0) config->selecao = SELECAO_TORNEIO;
+            else if (strcmp(valor, "amostragem") == 0) config->selecao = SELECAO_AMOSTRAGEM;
+            else if (strcmp(valor, "ranking") == 0) config->selecao = SELECAO_RANKING;
+            else ok = 0;
+        } else if (strcmp(opcao, "--torneio") == 0) {
+            ok = ler_inteiro(valor, &config->tamanho_torneio);
+        } else if (strcmp(opcao, "--pressao") == 0) {
+            ok = ler_real(valor, &config->pressao_ranking);
+        } else if (strcmp(opcao, "--crossover") == 0) {
+            ok = 1;
+            if (strcmp(valor, "metades") == 0) config->crossover = CROSSOVER_METADES;
+            else if (strcmp(valor, "um-ponto") == 0) config->crossover = CROSSOVER_UM_PONTO;
+            else if (strcmp(valor, "dois-pontos") == 0) config->crossover = CROSSOVER_DOIS_PONTOS;
+            else if (strcmp(valor, "posicional") == 0) config->crossover = CROSSOVER_POSICIONAL;
+            else ok = 0;
+        } else if (strcmp(opcao, "--estacionario") == 0) {
+            ok = ler_inteiro(valor, &config->lote_estacionario);
+        } else if (strcmp(opcao, "--cache") == 0) {
+            ok = ler_inteiro(valor, &config->cache_fitness);
+        } else if (strcmp(opcao, "--ilhas") == 0) {
+            ok = ler_inteiro(valor, &config->ilhas);
+        } else if (strcmp(opcao, "--intervalo-migracao") == 0) {
+            ok = ler_inteiro(valor, &config->intervalo_migracao);
+        } else if (strcmp(opcao, "--migrantes") == 0) {
+            ok = ler_inteiro(valor, &config->migrantes);
+        } else if (strcmp(opcao, "--trabalhadores") == 0) {
+            config->trabalhadores = valor;
+            ok = 1;
+        } else if (strcmp(opcao, "--trabalhadores-locais") == 0) {
+            ok = ler_inteiro(valor, &config->trabalhadores_locais);
+        } else if (strcmp(opcao, "--servir") == 0) {
+            config->endereco_servico = valor;
+            ok = 1;
+        } else if (strcmp(opcao, "--converter") == 0) {
+            config->arquivo_binario = valor;
+            ok = 1;
+        } else if (strcmp(opcao, "--populacoes") == 0) {
+            config->arquivo_populacoes = valor;
+            ok = 1;
+        } else if (strcmp(opcao, "--fila-populacoes") == 0) {
+            ok = ler_inteiro(valor, &config->fila_populacoes);
+        } else if (strcmp(opcao, "--descomprimir") == 0) {
+            config->arquivo_descomprimir = valor;
+            ok = 1;
+        } else if (strcmp(opcao, "--estado") == 0) {
+            config->arquivo_estado = valor;
+            ok = 1;
+        } else if (strcmp(opcao, "--intervalo-estado") == 0) {
+            ok = ler_inteiro(valor, &config->intervalo_estado);
+        } else if (strcmp(opcao, "--retomar") == 0) {
+            config->arquivo_retomada = valor;
+            ok = 1;
+        } else if (strcmp(opcao, "--telemetria") == 0) {
+            config->arquivo_telemetria = valor;
+            ok = 1;
+        } else if (strcmp(opcao, "--lote") == 0) {
+            config->arquivo_lote = valor;
+            ok = 1;
+        } else if (strcmp(opcao, "--resumo") == 0) {
+            config->arquivo_resumo = valor;
+            ok = 1;
+        } else if (strcmp(opcao, "-g") == 0 || strcmp(opcao, "--geracoes") == 0) {
+            ok = ler_inteiro(valor, &config->geracoes);
+        } else if (strcmp(opcao, "-p") == 0 || strcmp(opcao, "--populacao") == 0) {
+            ok = ler_inteiro(valor, &config->tamanho_populacao);
+        } else if (strcmp(opcao, "-e") == 0 || strcmp(opcao, "--elite") == 0) {
+            ok = ler_inteiro(valor, &config->elite);
+        } else if (strcmp(opcao, "-f") == 0 || strcmp(opcao, "--filhos") == 0) {
+            ok = ler_inteiro(valor, &config->max_filhos);
+        } else if (strcmp(opcao, "-t") == 0 || strcmp(opcao, "--taxa-mutacao") == 0) {
+            ok = ler_real(valor, &config->taxa_mutacao);
+        } else if (strcmp(opcao, "-c") == 0 || strcmp(opcao, "--tam-filho") == 0) {
+            ok = ler_inteiro(valor, &config->tam_filho);
+        } else if (strcmp(opcao, "--passeio-min") == 0) {
+            ok = ler_inteiro(valor, &config->passeio_min);
+        } else if (strcmp(opcao, "--passeio-max") == 0) {
+            ok = ler_inteiro(valor, &config->passeio_max);
+        } else if (strcmp(opcao, "-s") == 0 || strcmp(opcao, "--semente") == 0) {
+            ok = ler_semente(valor, &config->semente);
+        } else if (strcmp(opcao, "-j") == 0 || strcmp(opcao, "--threads") == 0) {
+            ok = ler_inteiro(valor, &config->threads);
+        } else if (strcmp(opcao, "--sem-melhora") == 0) {
+            ok = ler_inteiro(valor, &config->geracoes_sem_melhora);
+        } else if (strcmp(opcao, "--tempo-limite") == 0) {
+            float segundos = 0.0f;
+            ok = ler_real(valor, &segundos);
+            config->tempo_limite = segundos;
+        } else if (strcmp(opcao, "--max-avaliacoes") == 0) {
+            ok = ler_semente(valor, &config->max_avaliacoes);
+        } else if (strcmp(opcao, "--populacao-minima") == 0) {
+            ok = ler_inteiro(valor, &config->populacao_minima);
+        } else {
+            printf("Opcao desconhecida: %s\n", opcao);
+            return -1;
+        }
+        if (!ok) {
+            printf("Valor invalido para %s: %s\n", opcao, valor);
+            return -1;
+        }
+    }
+    return 1;
+}
+
+static void ligar_telemetria(Lista *lista, const Configuracao *config, FILE *telemetria) {
+    if (!telemetria) return;
+    definir_telemetria(lista, config->telemetria_json ? escrever_telemetria_json : escrever_telemetria_csv,
+                       telemetria);
+}
+
+/* Evolui uma única população enquanto o controlador permitir; retorna a
+ * população final ou NULL em erro. Com `distribuidor`, os filhos são
+ * avaliados nos trabalhadores; com `gravador`, a população inicial e a de
+ * cada geração são gravadas; com `salvamento`, o estado é salvo a cada
+ * intervalo e ao final. */
+static Lista *evoluir_populacao(const Configuracao *config, Matriz *matriz, FILE *telemetria, Distribuidor *distribuidor,
+                                Gravador *gravador, Salvamento *salvamento, Controlador *controlador) {
+    PoolThreads *pool = NULL;
+    if (config->threads > 1 && !distribuidor) {
+        pool = cria_pool_threads(matriz, config->threads, config->semente);
+        if (!pool) {
+            printf("Erro ao criar o pool de threads.\n");
+            return NULL;
+        }
+    }
+
+    // A retomada restaura também os geradores, por isso vem depois do pool
+    int inicio = 0;
+    Lista *populacao = config->arquivo_retomada ? restaurar_estado(config->arquivo_retomada, matriz, pool, controlador, &inicio)
+                                                : cria_lista_configurada(config);
+    if (!populacao) {
+        printf("Erro ao criar lista de população.\n");
+        liberar_pool_threads(pool);
+        return NULL;
+    }
+    ligar_telemetria(populacao, config, telemetria);
+
+    if (config->arquivo_retomada) {
+        printf("Execucao retomada apos a geracao %d.\n", inicio);
+    } else {
+        insere_elementos(populacao, matriz, config->tamanho_populacao);
+        if (gravador) gravar_populacao(gravador, populacao, 0);
+    }
+
+    time_t ultimo_salvamento = time(NULL);
+    int geracao = inicio;
+    while (controlar_execucao(controlador, populacao, geracao)) {
+        printf("Geração %d concluída.\n", geracao + 1);
+        Lista *nova_populacao = distribuidor ? nova_geracao_distribuida(populacao, distribuidor)
+                              : pool ? nova_geracao_paralela(populacao, pool)
+                                     : nova_geracao(populacao, matriz);
+        if (!nova_populacao) {
+            printf("Erro ao gerar nova população na geração %d.\n", geracao + 1);
+            liberar_pool_threads(pool);
+            liberar_lista(populacao);
+            return NULL;
+        }
+        populacao = nova_populacao;
+        geracao++;
+        if (gravador) gravar_populacao(gravador, populacao, geracao);
+        if (salvamento && difftime(time(NULL), ultimo_salvamento) >= config->intervalo_estado &&
+            salvar_estado(salvamento, populacao, matriz, pool, controlador, geracao, 0))
+            ultimo_salvamento = time(NULL);
+    }
+    if (salvamento)
+        salvar_estado(salvamento, populacao, matriz, pool, controlador, geracao, 1);
+
+    liberar_pool_threads(pool);
+    return populacao;
+}
+
+/* Critérios que exigem consultar o controlador a cada geração. */
+static int controle_por_geracao(const Configuracao *config) {
+    return config->parar_no_objetivo || config->geracoes_sem_melhora > 0 || config->tempo_limite > 0.0 ||
+           config->max_avaliacoes > 0 || config->mutacao_adaptativa || config->populacao_minima > 0;
+}
+
+/* Evolui as ilhas e reúne todas em uma população ordenada por fitness; a
+ * telemetria acompanha apenas a ilha 0. Sem critérios por geração, as ilhas
+ * evoluem de uma vez, sem esperar umas pelas outras. */
+static Lista *evoluir_ilhas(const Configuracao *config, Matriz *matriz, FILE *telemetria,
+                            Controlador *controlador) {
+    Arquipelago *arquipelago = cria_arquipelago(matriz, config);
+    if (!arquipelago) {
+        printf("Erro ao criar o arquipélago.\n");
+        return NULL;
+    }
+    ligar_telemetria(obter_ilha(arquipelago, 0), config, telemetria);
+
+    int geracao = 0;
+    while (controlar_arquipelago(controlador, arquipelago, geracao)) {
+        int passo = controle_por_geracao(config) ? 1 : config->geracoes - geracao;
+        if (!evoluir_arquipelago(arquipelago, passo)) {
+            printf("Erro ao evoluir o arquipélago.\n");
+            liberar_arquipelago(arquipelago);
+            return NULL;
+        }
+        geracao += passo;
+    }
+    printf("%d gerações concluídas em %d ilhas.\n", geracao, numero_ilhas(arquipelago));
+
+    Lista *populacao = cria_lista_configurada(config);
+    if (populacao) {
+        for (int i = 0; i < numero_ilhas(arquipelago); i++)
+            aplicar_elitismo(obter_ilha(arquipelago, i), populacao, config->tamanho_populacao);
+        ordenar_por_fitness(populacao);
+    }
+    liberar_arquipelago(arquipelago);
+    return populacao;
+}
+
+int main(int argc, char **argv) {
+    Configuracao config = configuracao_padrao();
+    int status = ler_argumentos(argc, argv, &config);
+    if (status <= 0) return status == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    // Os parâmetros da evolução retomada vêm do arquivo de estado
+    if (config.arquivo_retomada && !ler_configuracao_estado(config.arquivo_retomada, &config)) return EXIT_FAILURE;
+    if (!validar_configuracao(&config)) return EXIT_FAILURE;
+
+    if (config.arquivo_descomprimir) {
+        int ok = descomprimir_arquivo(config.arquivo_descomprimir, config.arquivo_saida);
+        if (ok) printf("Arquivo descomprimido em: %s\n", config.arquivo_saida);
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
-int main(void) {
-    const char *arquivo_saida = "resultado.csv";
-    const int num_individuos = 100;
-    const int num_geracoes = 50;
+    if (config.semente == 0) config.semente = (unsigned long long)time(NULL);
+    semear_aleatorio(config.semente);
 
-    srand((unsigned int)time(NULL));
+    if (config.arquivo_lote) {
+        ResumoLote resumo;
+        int ok = resolver_lote(&config, &resumo);
+        if (ok) {
+            printf("Lote: %d mapas, %d resolvidos, %d falhas em %.2f s (%.0f resolvidos por hora).\n",
+                   resumo.mapas, resumo.resolvidos, resumo.falhas, resumo.segundos,
+                   resumo.segundos > 0.0 ? resumo.resolvidos * 3600.0 / resumo.segundos : 0.0);
+            printf("Resultados salvos em: %s\n", config.arquivo_saida);
+        }
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
-    Matriz *matriz = carregar_mapa(ARQUIVO_MAPA);
+    Matriz *matriz = carregar_mapa(config.arquivo_mapa);
     if (!matriz) {
         printf("Erro ao carregar o mapa.\n");
         return EXIT_FAILURE;
     }
+    if (!definir_modo_fitness(matriz, config.modo_fitness) || !ativar_cache_fitness(matriz, config.cache_fitness)) {
+        liberar_matriz(matriz);
+        return EXIT_FAILURE;
+    }
 
-    Lista *populacao = cria_lista();
-    if (!populacao) {
-        printf("Erro ao criar lista de população.\n");
+    if (config.arquivo_binario) {
+        int secoes = config.binario_sem_metadados ? 0 : MAPA_VIZINHANCA | MAPA_DISTANCIA;
+        int ok = salvar_mapa_binario(matriz, config.arquivo_binario, secoes);
+        if (ok) printf("Mapa binario salvo em: %s\n", config.arquivo_binario);
+        liberar_matriz(matriz);
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (config.endereco_servico) {
+        printf("Atendendo avaliacoes em %s\n", config.endereco_servico);
+        fflush(stdout);
+        servir_avaliacao(matriz, config.endereco_servico);
         liberar_matriz(matriz);
         return EXIT_FAILURE;
     }
 
-    insere_elementos(populacao, matriz, num_individuos);
+    // Os trabalhadores locais são criados com fork(), antes do gravador, do
+    // salvamento e do pool iniciarem as suas threads; as ilhas avaliam localmente
+    int distribuida = config.ilhas == 1 && (config.trabalhadores_locais > 0 || config.trabalhadores);
+    Distribuidor *distribuidor = NULL;
+    if (distribuida && config.trabalhadores_locais > 0)
+        distribuidor = cria_distribuidor_local(matriz, config.trabalhadores_locais);
+    else if (distribuida)
+        distribuidor = cria_distribuidor(matriz, config.trabalhadores);
+    if (distribuida && !distribuidor) {
+        printf("Erro ao conectar aos trabalhadores.\n");
+        liberar_matriz(matriz);
+        return EXIT_FAILURE;
+    }
 
-    for (int i = 0; i < num_geracoes; i++) {
-        printf("Geração %d concluída.\n", i + 1);
-        Lista *nova_populacao = nova_geracao(populacao, matriz);
-        if (!nova_populacao) {
-            printf("Erro ao gerar nova população na geração %d.\n", i + 1);
-            liberar_lista(populacao);
+    FILE *telemetria = NULL;
+    if (config.arquivo_telemetria) {
+        telemetria = fopen(config.arquivo_telemetria, "w");
+        if (!telemetria) {
+            printf("Falha ao abrir arquivo %s\n", config.arquivo_telemetria);
+            liberar_distribuidor(distribuidor);
             liberar_matriz(matriz);
             return EXIT_FAILURE;
         }
-        populacao = nova_populacao;
+        if (!config.telemetria_json) escrever_cabecalho_telemetria_csv(telemetria);
+    }
+
+    Gravador *gravador = NULL;
+    if (config.arquivo_populacoes) {
+        gravador = cria_gravador(config.arquivo_populacoes, config.populacoes_binario ? SAIDA_BINARIA : SAIDA_CSV,
+                                 config.comprimir_populacoes, config.fila_populacoes, config.descartar_populacoes);
+        if (!gravador) {
+            if (telemetria) fclose(telemetria);
+            liberar_distribuidor(distribuidor);
+            liberar_matriz(matriz);
+            return EXIT_FAILURE;
+        }
+    }
+
+    Salvamento *salvamento = NULL;
+    if (config.arquivo_estado && !(salvamento = cria_salvamento(config.arquivo_estado))) {
+        if (gravador) fechar_gravador(gravador);
+        if (telemetria) fclose(telemetria);
+        liberar_distribuidor(distribuidor);
+        liberar_matriz(matriz);
+        return EXIT_FAILURE;
+    }
+
+    Controlador *controlador = cria_controlador(matriz, &config);
+    if (!controlador) printf("Erro ao criar o controlador da execucao.\n");
+    Lista *populacao = !controlador ? NULL
+                     : config.ilhas > 1 ? evoluir_ilhas(&config, matriz, telemetria, controlador)
+                                        : evoluir_populacao(&config, matriz, telemetria, distribuidor, gravador, salvamento,
+                                                            controlador);
+    if (populacao) {
+        const EstadoExecucao *estado = estado_execucao(controlador);
+        if (estado->motivo != PARADA_GERACOES)
+            printf("Execucao encerrada na geracao %d (%s), com %llu avaliacoes em %.2f s.\n", estado->geracao,
+                   descrever_parada(estado->motivo), estado->avaliacoes, estado->segundos);
+    }
+    liberar_controlador(controlador);
+    liberar_distribuidor(distribuidor);
+    if (telemetria) fclose(telemetria);
+    if (salvamento && !fechar_salvamento(salvamento) && populacao) {
+        liberar_lista(populacao);
+        populacao = NULL;
+    }
+    if (gravador) {
+        unsigned long long descartadas = geracoes_descartadas(gravador);
+        if (descartadas)
+            printf("%llu geracoes nao foram gravadas (fila cheia) e estao marcadas sem individuos em %s.\n",
+                   descartadas, config.arquivo_populacoes);
+        if (!fechar_gravador(gravador) && populacao) {
+            liberar_lista(populacao);
+            populacao = NULL;
+        }
+    }
+    if (!populacao) {
+        liberar_matriz(matriz);
+        return EXIT_FAILURE;
     }
 
-    salvar_lista_csv(populacao, arquivo_saida);
-    printf("Resultado final salvo em: %s\n", arquivo_saida);
+    salvar_lista_csv(populacao, config.arquivo_saida);
+    printf("Resultado final salvo em: %s\n", config.arquivo_saida);
+    EstatisticasCache cache;
+    if (estatisticas_cache_fitness(matriz, &cache) && cache.consultas > 0)
+        printf("Cache de fitness: %llu de %llu filhos encontrados (%.1f%%)\n", cache.acertos, cache.consultas,
+               100.0 * (double)cache.acertos / (double)cache.consultas);
 
     liberar_lista(populacao);
     liberar_matriz(matriz);